@@ -9,6 +9,7 @@
 #include <unistd.h>
 #include <netinet/tcp.h>
 #include <cerrno>
+#include <chrono>
 
 namespace emp {
 
@@ -19,6 +20,7 @@ public:
     std::string addr;
     int port;
     long long counter = 0;
+    int spin_us = 0; // busy-poll budget per recv_data, see set_busy_poll
 
     NetIO(const char* address, int port, bool quiet = false) {
         is_server = (address == nullptr);
@@ -101,6 +103,19 @@ public:
         setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
     }
 
+    // Low-latency receive: recv_data retries non-blocking reads for up to usec microseconds
+    // before blocking, and the socket gets SO_BUSY_POLL so a blocking read polls the device
+    // queue instead of sleeping. Returns false if the kernel refused SO_BUSY_POLL (raising it
+    // above net.core.busy_read needs CAP_NET_ADMIN); the user-space spin applies regardless.
+    bool set_busy_poll(int usec) {
+        spin_us = usec > 0 ? usec : 0;
+#ifdef SO_BUSY_POLL
+        return setsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &spin_us, sizeof(spin_us)) == 0;
+#else
+        return false;
+#endif
+    }
+
     void flush() {
         // TCP sockets are stream-oriented, flush is not needed in the same way as for buffers.
     }
@@ -121,10 +136,16 @@ public:
 
     void recv_data(void* data, size_t len) {
         size_t recv_len = 0;
+        bool spinning = spin_us > 0;
+        std::chrono::steady_clock::time_point spin_until;
+        if (spinning)
+            spin_until = std::chrono::steady_clock::now() + std::chrono::microseconds(spin_us);
         while(recv_len < len) {
-            ssize_t res = recv(sock, (char*)data + recv_len, len - recv_len, 0);
+            ssize_t res = recv(sock, (char*)data + recv_len, len - recv_len, spinning ? MSG_DONTWAIT : 0);
             if (res > 0) {
                 recv_len += res;
+            } else if (res < 0 && spinning && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+                spinning = std::chrono::steady_clock::now() < spin_until;
             } else if (res == 0) {
                 // Connection closed
                 break;
@@ -0,0 +1,287 @@
+#ifndef EMP_SHM_IO_H__
+#define EMP_SHM_IO_H__
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <new>
+#include <string>
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+namespace emp {
+
+// Same-host drop-in for NetIO: one POSIX shared-memory segment per channel holding two SPSC byte
+// rings (server->client and client->server). send_data/recv_data copy straight into/out of the
+// ring; a blocked side spins, then sleeps on a futex in the segment (cross-process). The spin
+// budget adapts: it grows while spinning pays off and shrinks when the wait ends in a sleep, and
+// is zero on single-CPU hosts where spinning only delays the peer.
+// The segment is named after the port, so channels must use distinct ports on one host (the
+// LOCALHOST port layout of NetIOMP does). Usage: NetIOMP<nP, ShmIO>.
+class ShmIO {
+public:
+	static constexpr size_t kRingBytes = size_t(1) << 20; // per direction, power of two
+	static constexpr int kMaxSpin = 4096; // pause iterations before sleeping on the futex
+
+	bool is_server;
+	int port;
+	long long counter = 0;
+
+	ShmIO(const char* address, int port, bool quiet = false) {
+		is_server = (address == nullptr);
+		this->port = port;
+		name = "/sc-shm-" + std::to_string(port);
+		const size_t bytes = sizeof(Segment) + 2 * kRingBytes;
+
+		int fd = -1;
+		if (is_server) {
+			shm_unlink(name.c_str()); // drop a segment left behind by a crashed run
+			fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+			if (fd < 0 || ftruncate(fd, static_cast<off_t>(bytes)) != 0) {
+				if (!quiet) perror("shm_open/ftruncate");
+				exit(EXIT_FAILURE);
+			}
+			seg = map(fd, bytes, quiet);
+			new (seg) Segment();
+			seg->magic.store(kMagic, std::memory_order_release);
+			// Like accept(): wait for the client, then unlink so nothing is left in /dev/shm
+			while (seg->clientAttached.load(std::memory_order_acquire) == 0) usleep(1000);
+			shm_unlink(name.c_str());
+		} else {
+			// Retry like NetIO's connect: the server may not have created the segment yet
+			const int max_retries = 5000; // ~5s with 1ms sleep
+			for (int attempt = 0;; ++attempt) {
+				fd = shm_open(name.c_str(), O_RDWR, 0600);
+				if (fd >= 0) {
+					struct stat st;
+					if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= bytes) {
+						seg = map(fd, bytes, quiet);
+						uint32_t expected = 0;
+						if (seg->magic.load(std::memory_order_acquire) == kMagic &&
+						    seg->clientAttached.compare_exchange_strong(expected, 1, std::memory_order_acq_rel)) {
+							break;
+						}
+						munmap(seg, bytes);
+						seg = nullptr;
+					}
+					close(fd);
+					fd = -1;
+				}
+				if (attempt >= max_retries) {
+					if (!quiet) std::cout << "\nShared-memory attach failed after retries\n";
+					exit(EXIT_FAILURE);
+				}
+				usleep(1000);
+			}
+		}
+		close(fd); // the mapping keeps the segment alive
+		mapped = bytes;
+		uint8_t* data = reinterpret_cast<uint8_t*>(seg + 1);
+		tx = &seg->rings[is_server ? 0 : 1];
+		rx = &seg->rings[is_server ? 1 : 0];
+		txData = data + (is_server ? 0 : kRingBytes);
+		rxData = data + (is_server ? kRingBytes : 0);
+		if(!quiet)
+			std::cout << "Connection established" << std::endl;
+	}
+
+	~ShmIO() {
+		// Let a peer blocked in recv_data/send_data observe the close, like a TCP FIN
+		seg->closed.store(1, std::memory_order_seq_cst);
+		for (Ring* r : {tx, rx}) {
+			r->dataSeq.fetch_add(1, std::memory_order_release);
+			r->spaceSeq.fetch_add(1, std::memory_order_release);
+			futexWake(&r->dataSeq);
+			futexWake(&r->spaceSeq);
+		}
+		munmap(seg, mapped);
+	}
+
+	ShmIO(const ShmIO&) = delete;
+	ShmIO& operator=(const ShmIO&) = delete;
+
+	void set_nodelay() {}
+	void flush() {}
+
+	void send_data(const void* data, size_t len) {
+		const uint8_t* src = static_cast<const uint8_t*>(data);
+		size_t done = 0;
+		while (done < len) {
+			const uint64_t head = tx->head.load(std::memory_order_relaxed);
+			size_t space = kRingBytes - static_cast<size_t>(head - tx->tail.load(std::memory_order_acquire));
+			if (space == 0) {
+				if (!waitFor(tx->spaceSeq, tx->producerWaiting, [&]() {
+					return tx->tail.load(std::memory_order_seq_cst) != head - kRingBytes;
+				})) peer_closed("send_data");
+				continue;
+			}
+			const size_t n = std::min(space, len - done);
+			copyIn(txData, head, src + done, n);
+			tx->head.store(head + n, std::memory_order_release);
+			done += n;
+			wakeIfWaiting(tx->dataSeq, tx->consumerWaiting);
+		}
+		counter += len;
+	}
+
+	void recv_data(void* data, size_t len) {
+		uint8_t* dst = static_cast<uint8_t*>(data);
+		size_t done = 0;
+		while (done < len) {
+			const uint64_t tail = rx->tail.load(std::memory_order_relaxed);
+			const size_t avail = static_cast<size_t>(rx->head.load(std::memory_order_acquire) - tail);
+			if (avail == 0) {
+				if (!waitFor(rx->dataSeq, rx->consumerWaiting, [&]() {
+					return rx->head.load(std::memory_order_seq_cst) != tail;
+				})) peer_closed("recv_data"); // nothing left to read
+				continue;
+			}
+			const size_t n = std::min(avail, len - done);
+			copyOut(dst + done, rxData, tail, n);
+			rx->tail.store(tail + n, std::memory_order_release);
+			done += n;
+			wakeIfWaiting(rx->spaceSeq, rx->producerWaiting);
+		}
+		counter += len;
+	}
+
+private:
+	// The peer went away mid-transfer. Like a NetIO send error this is fatal: returning would
+	// leave the caller believing all len bytes moved.
+	[[noreturn]] static void peer_closed(const char* op) {
+		std::fprintf(stderr, "ShmIO %s: peer closed the channel\n", op);
+		exit(EXIT_FAILURE);
+	}
+
+	static constexpr uint64_t kMagic = 0x5343534d52494e47ull; // "SCSMRING"
+
+	// One direction. head is written by the producer only, tail by the consumer only; each side's
+	// futex word and "waiting" flag sit on their own cache lines.
+	struct Ring {
+		alignas(64) std::atomic<uint64_t> head{0};
+		alignas(64) std::atomic<uint64_t> tail{0};
+		alignas(64) std::atomic<uint32_t> dataSeq{0};  // bumped when data arrives for a sleeping consumer
+		std::atomic<uint32_t> consumerWaiting{0};
+		alignas(64) std::atomic<uint32_t> spaceSeq{0}; // bumped when space frees for a sleeping producer
+		std::atomic<uint32_t> producerWaiting{0};
+	};
+	struct Segment {
+		std::atomic<uint64_t> magic{0};
+		std::atomic<uint32_t> clientAttached{0};
+		std::atomic<uint32_t> closed{0};
+		Ring rings[2];
+	};
+	static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared-memory rings need lock-free 64-bit atomics");
+
+	static Segment* map(int fd, size_t bytes, bool quiet) {
+		void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (p == MAP_FAILED) {
+			if (!quiet) perror("mmap");
+			exit(EXIT_FAILURE);
+		}
+		return static_cast<Segment*>(p);
+	}
+
+	static void copyIn(uint8_t* ring, uint64_t pos, const uint8_t* src, size_t n) {
+		const size_t off = static_cast<size_t>(pos & (kRingBytes - 1));
+		const size_t first = std::min(n, kRingBytes - off);
+		memcpy(ring + off, src, first);
+		memcpy(ring, src + first, n - first);
+	}
+	static void copyOut(uint8_t* dst, const uint8_t* ring, uint64_t pos, size_t n) {
+		const size_t off = static_cast<size_t>(pos & (kRingBytes - 1));
+		const size_t first = std::min(n, kRingBytes - off);
+		memcpy(dst, ring + off, first);
+		memcpy(dst + first, ring, n - first);
+	}
+
+	static void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+		_mm_pause();
+#else
+		sched_yield();
+#endif
+	}
+
+	static void futexWait(std::atomic<uint32_t>* word, uint32_t expected) {
+#ifdef __linux__
+		// Bounded, so the closed flag is rechecked periodically while asleep
+		struct timespec ts{0, 100 * 1000 * 1000};
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAIT, expected, &ts, nullptr, 0);
+#else
+		(void)word; (void)expected;
+		usleep(50);
+#endif
+	}
+	static void futexWake(std::atomic<uint32_t>* word) {
+#ifdef __linux__
+		syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), FUTEX_WAKE, 1, nullptr, nullptr, 0);
+#else
+		(void)word;
+#endif
+	}
+
+	// Spin, then sleep on seq until ready() holds. Returns false if the peer closed instead.
+	template<typename Ready>
+	bool waitFor(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiting, Ready ready) {
+		for (int i = 0; i < spinLimit; ++i) {
+			if (ready()) {
+				spinLimit = std::min(kMaxSpin, spinLimit * 2);
+				return true;
+			}
+			cpuRelax();
+		}
+		spinLimit = std::max(spinFloor, spinLimit / 2);
+		while (true) {
+			const uint32_t observed = seq.load(std::memory_order_acquire);
+			// Dekker pairing with wakeIfWaiting: either we see the update or the peer sees us waiting
+			waiting.store(1, std::memory_order_seq_cst);
+			if (ready()) {
+				waiting.store(0, std::memory_order_relaxed);
+				return true;
+			}
+			if (seg->closed.load(std::memory_order_acquire)) {
+				waiting.store(0, std::memory_order_relaxed);
+				return false;
+			}
+			futexWait(&seq, observed);
+			waiting.store(0, std::memory_order_relaxed);
+		}
+	}
+	static void wakeIfWaiting(std::atomic<uint32_t>& seq, std::atomic<uint32_t>& waiting) {
+		std::atomic_thread_fence(std::memory_order_seq_cst);
+		if (waiting.load(std::memory_order_relaxed)) {
+			seq.fetch_add(1, std::memory_order_release);
+			futexWake(&seq);
+		}
+	}
+
+	std::string name;
+	const int spinFloor = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? 16 : 0;
+	int spinLimit = spinFloor > 0 ? kMaxSpin : 0;
+	Segment* seg = nullptr;
+	size_t mapped = 0;
+	Ring* tx = nullptr;
+	Ring* rx = nullptr;
+	uint8_t* txData = nullptr;
+	uint8_t* rxData = nullptr;
+};
+
+} // namespace emp
+#endif // EMP_SHM_IO_H__
@@ -0,0 +1,178 @@
+#ifndef HYBRID_CHANNEL_H__
+#define HYBRID_CHANNEL_H__
+
+// Channel (see Channel.h) that routes each message by size: below a per-peer threshold it goes
+// over NetIOMP's socket, which has the lower small-message latency; at or above it over the
+// Communicator's DEALER, whose I/O thread batches large transfers. Both sides of a pair use the
+// same threshold and recv names the length, so the receiver reads each message from the path
+// its sender used, and per-peer order holds across the two paths without extra framing.
+//
+// calibrate() measures both paths with a short ping-pong per pair and settles the threshold on
+// the lower party's measurement. Until then every pair uses kDefaultThreshold. Needs
+// CommunicatorChannel.h, so link socket_communicator.
+#include "netmp_channel.h"
+#include "CommunicatorChannel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+template<int nP, typename IO = NetIO>
+class HybridChannel { public:
+	static constexpr size_t kDefaultThreshold = 64 * 1024;
+
+	// comm must know the party count and have its DEALERs set up; io is the matching NetIOMP.
+	// timeoutMs bounds each receive on the Communicator path.
+	HybridChannel(Communicator& comm, NetIOMP<nP, IO>& io, int timeoutMs = -1)
+		: net_(io), zmq_(comm, timeoutMs) {
+		std::fill(threshold_, threshold_ + nP + 1, kDefaultThreshold);
+		std::fill(dirty_, dirty_ + nP + 1, false);
+	}
+
+	int party() const { return net_.party(); }
+	int parties() const { return nP; }
+
+	bool send(int peer, const void * data, size_t len) {
+		if(len < threshold_[peer]) {
+			dirty_[peer] = true;
+			return net_.send(peer, data, len);
+		}
+		flush_net(peer); // an earlier small message must not wait behind this one
+		return zmq_.send(peer, data, len);
+	}
+	bool recv(int peer, void * data, size_t len) {
+		flush_net(peer); // as NetIOMP::recv_data: the peer may be waiting on what we sent
+		if(len < threshold_[peer])
+			return net_.recv(peer, data, len);
+		return zmq_.recv(peer, data, len);
+	}
+	bool broadcast(const void * data, size_t len) {
+		bool all_zmq = true;
+		for(int i = 1; i <= nP; ++i) if(i != party())
+			all_zmq = all_zmq and len >= threshold_[i];
+		if(all_zmq) {
+			flush_net(0);
+			return zmq_.broadcast(data, len); // one shared copy for every peer
+		}
+		bool ok = true;
+		for(int i = 1; i <= nP; ++i) if(i != party())
+			ok = send(i, data, len) and ok;
+		return ok;
+	}
+	void flush(int peer = 0) { flush_net(peer); }
+
+	// Messages to and from peer of at least `bytes` take the Communicator path. Both parties of
+	// the pair must set the same value. SIZE_MAX keeps everything on NetIOMP, 0 on the Communicator.
+	void set_threshold(int peer, size_t bytes) { threshold_[peer] = bytes; }
+	size_t threshold(int peer) const { return threshold_[peer]; }
+
+	// Collective: every party calls it at the same point with the same arguments (sizes ascending).
+	// For each pair the lower id times `iters` round trips (after a short warm-up) of every
+	// candidate size over both paths, picks the smallest size from which the Communicator's median
+	// wins at every larger candidate too, and sends it to the higher id. Pairs run in (lower, higher) order,
+	// which every party walks the same way, so no pair waits on a busy one forever.
+	// Returns false if any exchange failed; both sides of such a pair keep kDefaultThreshold. A
+	// Communicator receive that timed out may leave its late message queued on that path.
+	bool calibrate(const std::vector<size_t>& sizes = default_sizes(), int iters = 20) {
+		const int warmup = 3;
+		size_t largest = 0;
+		for(size_t s : sizes) largest = std::max(largest, s);
+		std::vector<char> buf(std::max<size_t>(largest, 1));
+		bool all_ok = true;
+		for(int peer = 1; peer <= nP; ++peer) {
+			if(peer == party()) continue;
+			const bool leader = party() < peer;
+			std::vector<uint64_t> net_ns(sizes.size()), zmq_ns(sizes.size());
+			bool ok = true;
+			for(size_t k = 0; k < sizes.size() and ok; ++k) {
+				ok = ping_pong(net_, peer, leader, buf.data(), sizes[k], warmup, iters, net_ns[k])
+					and ping_pong(zmq_, peer, leader, buf.data(), sizes[k], warmup, iters, zmq_ns[k]);
+			}
+			uint64_t chosen = UINT64_MAX;
+			if(leader) {
+				uint8_t peer_ok = 0;
+				ok = net_.recv(peer, &peer_ok, 1) and peer_ok == 1 and ok;
+				if(ok) {
+					for(size_t k = sizes.size(); k-- > 0 and zmq_ns[k] < net_ns[k]; )
+						chosen = sizes[k];
+				} else {
+					chosen = kCalibrationFailed;
+				}
+				uint64_t wire = NetIOMP<nP, IO>::to_le64(chosen);
+				ok = net_.send(peer, &wire, sizeof(wire)) and ok;
+				net_.flush(peer);
+			} else {
+				const uint8_t my_ok = ok ? 1 : 0;
+				ok = net_.send(peer, &my_ok, 1) and ok;
+				net_.flush(peer);
+				uint64_t wire = 0;
+				ok = net_.recv(peer, &wire, sizeof(wire)) and ok;
+				chosen = NetIOMP<nP, IO>::to_le64(wire);
+				if(chosen == kCalibrationFailed) ok = false;
+			}
+			if(!ok) {
+				threshold_[peer] = kDefaultThreshold;
+				all_ok = false;
+				continue;
+			}
+			threshold_[peer] = chosen == UINT64_MAX ? SIZE_MAX : static_cast<size_t>(chosen);
+		}
+		return all_ok;
+	}
+
+	// 64 B to 1 MiB in steps of 4x
+	static std::vector<size_t> default_sizes() {
+		std::vector<size_t> sizes;
+		for(size_t s = 64; s <= (size_t(1) << 20); s *= 4) sizes.push_back(s);
+		return sizes;
+	}
+
+	NetIOMPChannel<nP, IO>& net_channel() { return net_; }
+	CommunicatorChannel& zmq_channel() { return zmq_; }
+
+private:
+	void flush_net(int peer) {
+		if(peer == 0) {
+			for(int i = 1; i <= nP; ++i) if(i != party()) flush_net(i);
+		} else if(dirty_[peer]) {
+			net_.flush(peer);
+			dirty_[peer] = false;
+		}
+	}
+
+	// Sent by the lower id in place of a threshold when either side of the pair failed
+	static constexpr uint64_t kCalibrationFailed = UINT64_MAX - 1;
+
+	// Median round trip of `len` bytes echoed back by the follower (0 on the follower's side) into
+	// median; false, and stop, at the first send or receive that fails
+	template<typename Ch>
+	static bool ping_pong(Ch& ch, int peer, bool leader, char * buf, size_t len, int warmup, int iters, uint64_t& median) {
+		std::vector<uint64_t> samples;
+		median = 0;
+		for(int i = 0; i < warmup + iters; ++i) {
+			if(leader) {
+				auto start = std::chrono::steady_clock::now();
+				if(!ch.send(peer, buf, len)) return false;
+				ch.flush(peer);
+				if(!ch.recv(peer, buf, len)) return false;
+				auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+				if(i >= warmup) samples.push_back(static_cast<uint64_t>(ns));
+			} else {
+				if(!ch.recv(peer, buf, len)) return false;
+				if(!ch.send(peer, buf, len)) return false;
+				ch.flush(peer);
+			}
+		}
+		if(samples.empty()) return true;
+		std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+		median = samples[samples.size() / 2];
+		return true;
+	}
+
+	NetIOMPChannel<nP, IO> net_;
+	CommunicatorChannel zmq_;
+	size_t threshold_[nP+1];
+	bool dirty_[nP+1];
+};
+
+#endif //HYBRID_CHANNEL_H__
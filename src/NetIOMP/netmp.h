@@ -2,16 +2,25 @@
 #define NETIOMP_H__
 
 #include "common/net_io.h"
+#include "common/shm_io.h"
 #include "cmpc_config.h"
 #include <cstring>
+#include <cstdint>
+#include <vector>
 #include <unistd.h>
+#ifdef SC_ENABLE_TRACING
+#include "Trace.h"
+#elif !defined(SC_TRACE_SCOPE)
+#define SC_TRACE_SCOPE(var, op, party, peer, bytes) ((void)0)
+#endif
 
 using namespace emp;
 
-template<int nP>
+// IO is the per-pair channel: NetIO (TCP, default) or ShmIO (shared memory, same host only).
+template<int nP, typename IO = NetIO>
 class NetIOMP { public:
-	NetIO*ios[nP+1];
-	NetIO*ios2[nP+1];
+	IO*ios[nP+1];
+	IO*ios2[nP+1];
 	int party;
 	bool sent[nP+1];
 	NetIOMP(int party, int port) {
@@ -21,37 +30,37 @@ class NetIOMP { public:
 			if(i == party) {
 #ifdef LOCALHOST
 				usleep(1000);
-				ios[j] = new NetIO(IP[j], port+2*(i*nP+j), true);
+				ios[j] = new IO(IP[j], port+2*(i*nP+j), true);
 #else
 				usleep(1000);
-				ios[j] = new NetIO(IP[j], port+2*(i), true);
+				ios[j] = new IO(IP[j], port+2*(i), true);
 #endif
 				ios[j]->set_nodelay();	
 
 #ifdef LOCALHOST
 				usleep(1000);
-				ios2[j] = new NetIO(nullptr, port+2*(i*nP+j)+1, true);
+				ios2[j] = new IO(nullptr, port+2*(i*nP+j)+1, true);
 #else
 				usleep(1000);
-				ios2[j] = new NetIO(nullptr, port+2*(j)+1, true);
+				ios2[j] = new IO(nullptr, port+2*(j)+1, true);
 #endif
 				ios2[j]->set_nodelay();	
 			} else if(j == party) {
 #ifdef LOCALHOST
 				usleep(1000);
-				ios[i] = new NetIO(nullptr, port+2*(i*nP+j), true);
+				ios[i] = new IO(nullptr, port+2*(i*nP+j), true);
 #else
 				usleep(1000);
-				ios[i] = new NetIO(nullptr, port+2*(i), true);
+				ios[i] = new IO(nullptr, port+2*(i), true);
 #endif
 				ios[i]->set_nodelay();	
 
 #ifdef LOCALHOST
 				usleep(1000);
-				ios2[i] = new NetIO(IP[i], port+2*(i*nP+j)+1, true);
+				ios2[i] = new IO(IP[i], port+2*(i*nP+j)+1, true);
 #else
 				usleep(1000);
-				ios2[i] = new NetIO(IP[i], port+2*(j)+1, true);
+				ios2[i] = new IO(IP[i], port+2*(j)+1, true);
 #endif
 				ios2[i]->set_nodelay();	
 			}
@@ -74,6 +83,7 @@ class NetIOMP { public:
 			}
 	}
 	void send_data(int dst, const void * data, size_t len) {
+		SC_TRACE_SCOPE(trace, NetSend, party, dst, len);
 		if(dst != 0 and dst!= party) {
 			if(party < dst)
 				ios[dst]->send_data(data, len);
@@ -86,6 +96,7 @@ class NetIOMP { public:
 #endif
 	}
 	void recv_data(int src, void * data, size_t len) {
+		SC_TRACE_SCOPE(trace, NetRecv, party, src, len);
 		if(src != 0 and src!= party) {
 			if(sent[src])flush(src);
 			if(src < party)
@@ -94,7 +105,47 @@ class NetIOMP { public:
 				ios2[src]->recv_data(data, len);
 		}
 	}
-	NetIO*& get(size_t idx, bool b = false){
+	// Typed share vectors: [count: u64][count x u64], little-endian on the wire.
+	void send_vec(int dst, const uint64_t * data, size_t count) {
+		uint64_t n = to_le64(count);
+		send_data(dst, &n, sizeof(n));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		send_data(dst, data, count * sizeof(uint64_t));
+#else
+		std::vector<uint64_t> le(data, data + count);
+		for(auto& v : le) v = to_le64(v);
+		send_data(dst, le.data(), count * sizeof(uint64_t));
+#endif
+	}
+	void send_vec(int dst, const std::vector<uint64_t>& values) {
+		send_vec(dst, values.data(), values.size());
+	}
+	void recv_vec(int src, std::vector<uint64_t>& out) {
+		uint64_t n = 0;
+		recv_data(src, &n, sizeof(n));
+		out.resize(static_cast<size_t>(to_le64(n)));
+		recv_data(src, out.data(), out.size() * sizeof(uint64_t));
+#if !(defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+		for(auto& v : out) v = to_le64(v);
+#endif
+	}
+	static uint64_t to_le64(uint64_t v) {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		return v;
+#else
+		return __builtin_bswap64(v);
+#endif
+	}
+	// NetIO only: busy-poll receives on every socket (see NetIO::set_busy_poll). ShmIO already spins.
+	bool set_busy_poll(int usec) {
+		bool ok = true;
+		for(int i = 1; i <= nP; ++i) if(i != party) {
+			ok = ios[i]->set_busy_poll(usec) and ok;
+			ok = ios2[i]->set_busy_poll(usec) and ok;
+		}
+		return ok;
+	}
+	IO*& get(size_t idx, bool b = false){
 		if (b) return ios2[idx];
 		else return ios[idx];
 	}
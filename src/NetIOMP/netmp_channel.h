@@ -0,0 +1,39 @@
+#ifndef NETIOMP_CHANNEL_H__
+#define NETIOMP_CHANNEL_H__
+
+// Channel adapter (see Channel.h) over NetIOMP. NetIOMP's IO classes exit the process on
+// socket errors and ShmIO also when its peer closes mid-transfer, so send/recv/broadcast always
+// report success. (NetIO's recv_data stops early on a cleanly closed socket instead.) Sends are
+// buffered until flush or the next recv from the same peer.
+#include "netmp.h"
+#include "Channel.h"
+
+template<int nP, typename IO = NetIO>
+class NetIOMPChannel { public:
+	explicit NetIOMPChannel(NetIOMP<nP, IO>& io) : io(io) {}
+
+	int party() const { return io.party; }
+	int parties() const { return nP; }
+
+	bool send(int peer, const void * data, size_t len) {
+		io.send_data(peer, data, len);
+		return true;
+	}
+	bool recv(int peer, void * data, size_t len) {
+		io.recv_data(peer, data, len);
+		return true;
+	}
+	bool broadcast(const void * data, size_t len) {
+		for(int i = 1; i <= nP; ++i) if(i != io.party)
+			io.send_data(i, data, len);
+		return true;
+	}
+	void flush(int peer = 0) { io.flush(peer); }
+
+	NetIOMP<nP, IO>& netio() { return io; }
+
+private:
+	NetIOMP<nP, IO>& io;
+};
+
+#endif //NETIOMP_CHANNEL_H__
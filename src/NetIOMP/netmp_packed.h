@@ -0,0 +1,35 @@
+#ifndef NETIOMP_PACKED_H__
+#define NETIOMP_PACKED_H__
+
+// Bit-packed share vectors over NetIOMP: [count: u64 LE][count x `bits` bits], see FieldPacking.h.
+// Kept out of netmp.h so the core NetIOMP header stays header-only; link socket_communicator.
+#include "netmp.h"
+#include "FieldPacking.h"
+
+template<int nP, typename IO>
+void send_packed(NetIOMP<nP, IO>& io, int dst, const uint64_t * data, size_t count, unsigned bits) {
+	thread_local std::vector<uint8_t> scratch;
+	scratch.resize(fieldpack::packedSize(count, bits));
+	fieldpack::pack(data, count, bits, scratch.data());
+	uint64_t n = NetIOMP<nP, IO>::to_le64(count);
+	io.send_data(dst, &n, sizeof(n));
+	io.send_data(dst, scratch.data(), scratch.size());
+}
+
+template<int nP, typename IO>
+void send_packed(NetIOMP<nP, IO>& io, int dst, const std::vector<uint64_t>& values, unsigned bits) {
+	send_packed(io, dst, values.data(), values.size(), bits);
+}
+
+template<int nP, typename IO>
+void recv_packed(NetIOMP<nP, IO>& io, int src, std::vector<uint64_t>& out, unsigned bits) {
+	thread_local std::vector<uint8_t> scratch;
+	uint64_t n = 0;
+	io.recv_data(src, &n, sizeof(n));
+	out.resize(static_cast<size_t>(NetIOMP<nP, IO>::to_le64(n)));
+	scratch.resize(fieldpack::packedSize(out.size(), bits));
+	io.recv_data(src, scratch.data(), scratch.size());
+	fieldpack::unpack(scratch.data(), out.size(), bits, out.data());
+}
+
+#endif //NETIOMP_PACKED_H__
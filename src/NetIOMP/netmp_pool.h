@@ -0,0 +1,28 @@
+#ifndef NETIOMP_POOL_H__
+#define NETIOMP_POOL_H__
+
+// Variable-length messages over NetIOMP: [len: u64 LE][len bytes]. recv_framed reads the body
+// into a block from a BufferPool (see BufferPool.h), so a steady stream of frames reuses the same
+// few blocks instead of allocating one per message. Link socket_communicator.
+#include "netmp.h"
+#include "BufferPool.h"
+
+template<int nP, typename IO>
+void send_framed(NetIOMP<nP, IO>& io, int dst, const void * data, size_t len) {
+	uint64_t n = NetIOMP<nP, IO>::to_le64(len);
+	io.send_data(dst, &n, sizeof(n));
+	if(len) io.send_data(dst, data, len);
+}
+
+// Receive one frame from src; the buffer goes back to pool when the PooledBuffer is dropped
+template<int nP, typename IO>
+PooledBuffer recv_framed(NetIOMP<nP, IO>& io, int src, BufferPool& pool) {
+	uint64_t n = 0;
+	io.recv_data(src, &n, sizeof(n));
+	const size_t len = static_cast<size_t>(NetIOMP<nP, IO>::to_le64(n));
+	PooledBuffer buf(pool, len);
+	if(len) io.recv_data(src, buf.data(), len);
+	return buf;
+}
+
+#endif //NETIOMP_POOL_H__
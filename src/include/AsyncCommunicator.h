@@ -0,0 +1,88 @@
+#ifndef ASYNC_COMMUNICATOR_H
+#define ASYNC_COMMUNICATOR_H
+
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <zmq.hpp>
+
+class Communicator;
+
+// Asynchronous front end over a Communicator's ROUTER, per-peer DEALERs and SUB socket.
+// One event-loop thread owns the Communicator (ZMQ sockets are thread-affine) and multiplexes
+// all sockets plus a wake-up pipe in a single poll. Calls from any thread return std::futures,
+// so a party can compute the next batch of shares while a round's messages are in flight.
+class AsyncCommunicator {
+public:
+    // Sets up ROUTER + per-peer DEALERs (and PUB/SUB if withPubSub) on the loop thread and
+    // returns once setup has finished. Throws if setup failed.
+    AsyncCommunicator(int id, int port_base, std::string address, int num_parties, bool withPubSub = false);
+    ~AsyncCommunicator();
+
+    AsyncCommunicator(const AsyncCommunicator&) = delete;
+    AsyncCommunicator& operator=(const AsyncCommunicator&) = delete;
+
+    int getId() const noexcept { return id_; }
+    // Pin the loop thread, which owns every socket, to one core (see CpuAffinity.h)
+    bool pinLoopThread(int core);
+
+    // Resolve to true once the message was handed to the peer's DEALER.
+    std::future<bool> asyncSend(int peerId, const std::string& payload);
+    std::future<bool> asyncSend(int peerId, zmq::message_t&& payload);
+    // Shared-buffer broadcast to every peer (see Communicator::dealerSendToAll).
+    std::future<bool> asyncSendToAll(const std::string& payload);
+    // PUB/SUB broadcast (requires withPubSub).
+    std::future<bool> asyncPublish(const std::string& payload);
+
+    // Resolve with the next ROUTER message from peerId. Requests for the same peer are served in order.
+    std::future<zmq::message_t> asyncRecvFrom(int peerId);
+    // Resolve with the next PUB/SUB message published by publisherId (requires withPubSub).
+    std::future<zmq::message_t> asyncSubRecvFrom(int publisherId);
+
+private:
+    enum class Op { Send, SendToAll, Publish, RecvFrom, SubRecvFrom, Stop };
+    struct Command {
+        Op op = Op::Stop;
+        int peer = 0;
+        zmq::message_t payload;
+        std::promise<bool> sent;
+        std::promise<zmq::message_t> received;
+    };
+    // Per-peer queues of delivered-but-unclaimed messages and claimed-but-undelivered receives
+    struct Inbox {
+        std::deque<zmq::message_t> arrived;
+        std::deque<std::promise<zmq::message_t>> waiting;
+    };
+
+    std::future<bool> submitSend(Op op, int peerId, zmq::message_t&& payload);
+    std::future<zmq::message_t> submitRecv(Op op, int peerId);
+    void submit(Command&& cmd);
+    void runLoop(std::promise<void> ready);
+    void execute(Command& cmd);
+    static void deliver(Inbox& inbox, zmq::message_t&& msg);
+
+    int id_;
+    int port_base_;
+    std::string address_;
+    int num_parties_;
+    bool withPubSub_;
+
+    // Loop-thread state
+    std::unique_ptr<Communicator> comm_;
+    std::unordered_map<int, Inbox> routerInbox_;
+    std::unordered_map<int, Inbox> subInbox_;
+    bool stopping_ = false;
+
+    // Submission queue shared with callers; wakeFds_ is a self-pipe that interrupts the poll
+    std::mutex queueMutex_;
+    std::deque<Command> queue_;
+    int wakeFds_[2] = {-1, -1};
+
+    std::thread loop_;
+};
+
+#endif // ASYNC_COMMUNICATOR_H
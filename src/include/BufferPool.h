@@ -0,0 +1,85 @@
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+// Payload buffers for the send paths, recycled instead of going through malloc/free per message.
+// Requests are rounded up to power-of-two size classes (64 B .. 4 MiB; larger ones go straight to
+// the heap). Each thread keeps a small cache per class and trades blocks with the pool's shared
+// lists in batches, so the common allocate/release is a few loads and stores with no lock. A
+// block may be released on any thread: ZeroMQ frees sent messages on its I/O thread, which
+// caches them and spills batches back for the sending thread to pick up.
+//
+// Buffers stay valid after the pool is destroyed (ZeroMQ may release a message after its
+// Communicator is gone); they then go back to the heap as they are released.
+class BufferPool {
+public:
+    static constexpr unsigned kMinShift = 6;  // 64 B
+    static constexpr unsigned kMaxShift = 22; // 4 MiB
+    static constexpr unsigned kClasses = kMaxShift - kMinShift + 1;
+
+    struct Stats {
+        uint64_t allocations = 0; // allocate calls
+        uint64_t fresh = 0;       // of those, served by the heap rather than a recycled block
+        uint64_t outstanding = 0; // blocks handed out (or cached by a thread) and not yet back
+    };
+
+    BufferPool();
+    ~BufferPool();
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // At least `bytes` usable bytes, 16-byte aligned. Never returns null (throws std::bad_alloc).
+    void* allocate(size_t bytes);
+    // Return a block from any pool, on any thread, even after its pool is gone. Null is ignored.
+    static void release(void* block) noexcept;
+    // zmq_free_fn-compatible: zmq::message_t(block, size, &BufferPool::freeFn, nullptr)
+    static void freeFn(void* block, void*) noexcept { release(block); }
+
+    Stats stats() const noexcept;
+
+    // Size class of a request, kClasses if it is too large to pool
+    static unsigned classOf(size_t bytes) noexcept;
+    static size_t classBytes(unsigned cls) noexcept { return size_t(1) << (kMinShift + cls); }
+
+    struct Core;
+
+private:
+    Core* core_;
+};
+
+// Owns one pooled block; released when destroyed
+class PooledBuffer {
+public:
+    PooledBuffer() noexcept = default;
+    PooledBuffer(BufferPool& pool, size_t bytes) : data_(pool.allocate(bytes)), size_(bytes) {}
+    ~PooledBuffer() { BufferPool::release(data_); }
+    PooledBuffer(PooledBuffer&& o) noexcept : data_(std::exchange(o.data_, nullptr)), size_(std::exchange(o.size_, 0)) {}
+    PooledBuffer& operator=(PooledBuffer&& o) noexcept {
+        if (this != &o) {
+            BufferPool::release(data_);
+            data_ = std::exchange(o.data_, nullptr);
+            size_ = std::exchange(o.size_, 0);
+        }
+        return *this;
+    }
+    PooledBuffer(const PooledBuffer&) = delete;
+    PooledBuffer& operator=(const PooledBuffer&) = delete;
+
+    void* data() noexcept { return data_; }
+    const void* data() const noexcept { return data_; }
+    size_t size() const noexcept { return size_; }
+    // Hand the block to a new owner (e.g. zmq_msg_init_data with BufferPool::freeFn)
+    void* release() noexcept {
+        size_ = 0;
+        return std::exchange(data_, nullptr);
+    }
+
+private:
+    void* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+#endif // BUFFER_POOL_H
@@ -0,0 +1,101 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+// Backend-agnostic party-to-party channel. A channel type C provides
+//   int  party() const            own id, 1..parties()
+//   int  parties() const
+//   bool send(int peer, const void* data, size_t len)
+//   bool recv(int peer, void* data, size_t len)
+//   bool broadcast(const void* data, size_t len)    same payload to every peer
+//   void flush(int peer)                             peer 0: every peer
+// with message semantics: each recv consumes exactly one send of the same length from that peer,
+// in the order they were sent. That is the subset both backends honour, so protocol code written
+// against it runs unchanged over CommunicatorChannel (CommunicatorChannel.h) and NetIOMPChannel
+// (NetIOMP/netmp_channel.h). Sends may be buffered until flush or the next recv from that peer.
+//
+// Protocol code takes the channel as a template parameter, so every call is resolved at compile
+// time and inlined into the hot loop. Where the backend is only known at run time, AnyChannel
+// wraps an adapter behind one virtual call per operation.
+
+template <typename C, typename = void>
+struct IsChannel : std::false_type {};
+
+template <typename C>
+struct IsChannel<C, std::void_t<
+    decltype(int(std::declval<const C&>().party())),
+    decltype(int(std::declval<const C&>().parties())),
+    decltype(bool(std::declval<C&>().send(1, std::declval<const void*>(), size_t(0)))),
+    decltype(bool(std::declval<C&>().recv(1, std::declval<void*>(), size_t(0)))),
+    decltype(bool(std::declval<C&>().broadcast(std::declval<const void*>(), size_t(0)))),
+    decltype(std::declval<C&>().flush(0))>> : std::true_type {};
+
+class AnyChannel {
+public:
+    virtual ~AnyChannel() = default;
+    virtual int party() const = 0;
+    virtual int parties() const = 0;
+    virtual bool send(int peer, const void* data, size_t len) = 0;
+    virtual bool recv(int peer, void* data, size_t len) = 0;
+    virtual bool broadcast(const void* data, size_t len) = 0;
+    virtual void flush(int peer = 0) = 0;
+
+    // Wrap an adapter by reference; it must outlive the wrapper
+    template <typename C>
+    static std::unique_ptr<AnyChannel> wrap(C& channel);
+};
+
+template <typename C>
+class AnyChannelOf final : public AnyChannel {
+    static_assert(IsChannel<C>::value, "C does not provide the channel operations (see Channel.h)");
+
+public:
+    explicit AnyChannelOf(C& channel) noexcept : c_(channel) {}
+    int party() const override { return c_.party(); }
+    int parties() const override { return c_.parties(); }
+    bool send(int peer, const void* data, size_t len) override { return c_.send(peer, data, len); }
+    bool recv(int peer, void* data, size_t len) override { return c_.recv(peer, data, len); }
+    bool broadcast(const void* data, size_t len) override { return c_.broadcast(data, len); }
+    void flush(int peer = 0) override { c_.flush(peer); }
+
+private:
+    C& c_;
+};
+
+template <typename C>
+std::unique_ptr<AnyChannel> AnyChannel::wrap(C& channel) {
+    return std::make_unique<AnyChannelOf<C>>(channel);
+}
+
+// Every party sends len bytes of data to every other party; peer p's bytes land at
+// out + (p - 1) * len (own slot untouched). Step k sends to party+k while receiving from party-k,
+// in pieces of at most `piece` bytes, so a party never has more than one piece unread toward
+// its target: blocking stream backends cannot deadlock whatever len is.
+template <typename Ch>
+bool allToAll(Ch& ch, const void* data, void* out, size_t len, size_t piece = 64 * 1024) {
+    static_assert(IsChannel<Ch>::value, "Ch does not provide the channel operations (see Channel.h)");
+    const int n = ch.parties();
+    const int me = ch.party();
+    const char* from = static_cast<const char*>(data);
+    for (int k = 1; k < n; ++k) {
+        const int dst = (me - 1 + k) % n + 1;
+        const int src = (me - 1 - k + n) % n + 1;
+        char* into = static_cast<char*>(out) + len * static_cast<size_t>(src - 1);
+        size_t off = 0;
+        do {
+            const size_t chunk = len - off < piece ? len - off : piece;
+            if (!ch.send(dst, from + off, chunk)) return false;
+            ch.flush(dst);
+            if (!ch.recv(src, into + off, chunk)) return false;
+            off += chunk;
+        } while (off < len);
+    }
+    return true;
+}
+
+#endif // CHANNEL_H
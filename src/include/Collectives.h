@@ -0,0 +1,50 @@
+#ifndef COLLECTIVES_H
+#define COLLECTIVES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class Communicator;
+
+// Collective operations over uint64 vectors mod Q, built on a Communicator's per-peer
+// DEALER/ROUTER sockets. Instead of an all-to-all exchange (N-1 sends per party):
+//   broadcast / reduce  binomial tree, at most ceil(log2 N) messages per party
+//   allreduce           ring reduce-scatter + allgather, 2(N-1) messages of len/N values each,
+//                       so every link carries the same ~2*len values regardless of N
+// Each call uses one round tag (see Communicator::dealerSendRound), taken from a counter that
+// starts at firstRound, so consecutive collectives never mix messages. Application rounds must
+// stay below firstRound, and every party must issue the same collectives in the same order.
+// Payloads are bit-packed to ceil(log2 Q) bits per value (see FieldPacking.h).
+class Collectives {
+public:
+    // comm must have its ROUTER and per-peer DEALERs set up and know the party count.
+    // Inputs must already be reduced mod modulus (2 <= modulus).
+    Collectives(Communicator& comm, uint64_t modulus, uint32_t firstRound = 0x80000000u);
+
+    uint64_t getModulus() const noexcept { return modulus_; }
+
+    // Replace data at every non-root party with root's data. timeoutMs bounds each receive.
+    bool broadcast(std::vector<uint64_t>& data, int root, int timeoutMs = -1);
+    // Element-wise sum mod Q of every party's data, left in data at root. Other parties' data is
+    // used as scratch. All parties must pass vectors of the same length.
+    bool reduce(std::vector<uint64_t>& data, int root, int timeoutMs = -1);
+    // Element-wise sum mod Q of every party's data, left in data at every party.
+    bool allreduce(std::vector<uint64_t>& data, int timeoutMs = -1);
+
+private:
+    bool sendValues(int peerId, uint32_t round, const uint64_t* values, size_t count);
+    // Receive exactly `expected` values (any count if expected is SIZE_MAX) into scratch_
+    bool recvValues(int peerId, uint32_t round, size_t expected, int timeoutMs);
+    void addInto(uint64_t* acc, const uint64_t* values, size_t count) const noexcept;
+
+    Communicator& comm_;
+    uint64_t modulus_;
+    unsigned bits_;
+    uint32_t nextRound_;
+    int id_;
+    int n_;
+    std::vector<uint64_t> scratch_;
+};
+
+#endif // COLLECTIVES_H
@@ -6,10 +6,30 @@
 #include <thread>
 #include <memory>
 #include <unordered_map>
+#include <deque>
+#include <map>
+#include <chrono>
 #include <zmq.hpp>
 #include <cstdint>
+#include <functional>
+#include "PeerMetrics.h"
+#include "BufferPool.h"
+
+class PeerSendPool;
+
 class Communicator {
 public:
+    // How sockets reach each other. Endpoints are derived from the same port numbers in every mode:
+    //   Tcp    tcp://address:port (default)
+    //   Ipc    ipc:///tmp/sc-<uid>-<port>.ipc, all parties on this host and run by one user
+    //   Inproc inproc://sc-<port>, all parties in this process sharing one context
+    //   Auto   per peer: inproc if an Auto party bound it in this process on the same context,
+    //          ipc if an Auto party bound it in this process on another context and address is
+    //          one of this host's addresses, else tcp (so a peer in another process must bind
+    //          tcp, as Tcp and Auto do). Auto binds every endpoint the host can serve so peers
+    //          using any mode can connect.
+    enum class Transport { Tcp, Ipc, Inproc, Auto };
+
     Communicator(int id, int port_base, std::string address);
     Communicator(int id, int port_base, std::string address, int num_parties);
     ~Communicator();
@@ -18,6 +38,18 @@ public:
     int getId() const noexcept { return id; }
     int getPortBase() const noexcept { return port_base; }
     const std::string& getAddress() const noexcept { return address; }
+    int getNumParties() const noexcept { return num_parties; }
+
+    // Select the transport; call before any setUp*. Inproc and Auto default to the process-wide
+    // context (processContext()) so parties in one process can reach each other.
+    void setTransport(Transport transport) noexcept { transport_ = transport; }
+    Transport getTransport() const noexcept { return transport_; }
+    // Use ctx for all sockets instead of a private context; call before any setUp*.
+    void useContext(std::shared_ptr<zmq::context_t> ctx) { context_ = std::move(ctx); }
+    // Context shared by every Communicator in this process that opts into it
+    static std::shared_ptr<zmq::context_t> processContext();
+    // Endpoint the DEALER for peerId connected to (empty before setUpPerPeerDealers)
+    std::string dealerEndpoint(int peerId) const;
 
     // run router or dealer mod
     void setUpRouter();
@@ -25,24 +57,162 @@ public:
     // Call this after all routers are bound. Skips self.
     void setUpPerPeerDealers();
     void setUpRouterDealer();
+    // Mesh mode, an alternative to setUpRouterDealer: one ROUTER per party that binds on
+    // port_base + id and connects to every lower-id peer (higher ids connect to us), so each pair
+    // shares one connection and a party holds 1 socket instead of N. Peers are addressed by
+    // routing id (the decimal party id) and every send API works unchanged. Sends to a peer whose
+    // connection is not up yet are retried until the credit/send timeout (setCreditTimeout).
+    // dealerSendToAllParallel falls back to sequential sends since the socket is shared.
+    void setUpMesh();
+    bool isMesh() const noexcept { return mesh_; }
+
+    // Readiness barrier, called after setup in place of a fixed sleep. Returns once every peer is
+    // reachable in both directions over DEALER/ROUTER (or the mesh ROUTER) and, when PUB and SUB
+    // are both set up, every peer's PUB reaches our SUB and ours reaches theirs. All peers are
+    // probed at once with Hello/HelloAck control frames and PUB beacons; peers answer from any
+    // receive call, so parties need not enter the barrier together. Application messages that
+    // arrive meanwhile are kept for the receive calls. Returns false if the deadline passes.
+    bool awaitMeshReady(std::chrono::steady_clock::time_point deadline);
+    bool awaitMeshReady(int timeoutMs) { return awaitMeshReady(deadlineAfter(timeoutMs)); }
 
     // Fast broadcast path using PUB/SUB (minimal checks for speed)
-    // Bind a PUB socket on tcp://address:(port_base + 1000 + id)
+    // Bind a PUB socket on port (port_base + 1000 + id) of the selected transport
     void setUpPublisher();
     // Create one SUB socket and connect to every peer's PUB (skip self). Subscribes to all topics.
     void setUpSubscribers();
 
     // Messaging API
-    // Dealer sends a single-frame payload to connected router(s).
-    // Returns true on success, false on failure.
+    // Broadcast a single-frame payload to every peer ROUTER through the per-peer DEALERs.
+    // The payload is copied once into a reference-counted zmq buffer that all peers share.
+    // Returns true only if every per-peer send succeeded.
     bool dealerSendToAll(const std::string& payload);
+    bool dealerSendToAll(zmq::message_t&& payload);
 
-    // Send the payload to all peer ROUTERs in parallel (one thread per peer, each with its own DEALER socket)
+    // Send the payload to all peer ROUTERs in parallel. Uses a persistent pool with one sender
+    // thread per peer (started on first use), each driving that peer's DEALER socket.
+    // Like dealerSendToAll, peers share one copy of the payload.
     bool dealerSendToAllParallel(const std::string& payload);
+    bool dealerSendToAllParallel(zmq::message_t&& payload);
 
     // Router receives one message in form [identity][payload].
     // If timeoutMs < 0, block until a message arrives; otherwise wait up to timeoutMs.
     bool routerReceive(std::string& fromIdentity, std::string& payload, int timeoutMs = -1);
+    // Zero-copy variant: moves the payload frame out to the caller and reports the sender's
+    // party id (parsed from its routing id, -1 if not numeric). No string copies or allocations.
+    bool routerReceive(int& fromId, zmq::message_t& payload, int timeoutMs = -1);
+    // View variant: calls onMessage(int fromId, const void* data, size_t size) on the received
+    // frame. The view is only valid for the duration of the call.
+    template <typename F>
+    bool routerReceiveView(F&& onMessage, int timeoutMs = -1) {
+        int fromId = -1;
+        if (!routerReceive(fromId, viewScratch_, timeoutMs)) return false;
+        onMessage(fromId, static_cast<const void*>(viewScratch_.data()), viewScratch_.size());
+        return true;
+    }
+
+    // Receive the next message from one specific peer. Messages from other peers that arrive
+    // first are kept, in order, and handed out by later receive calls.
+    bool routerReceiveFrom(int peerId, zmq::message_t& payload, int timeoutMs = -1);
+
+    // Gather one message from every peer under a single deadline (fan-in for one protocol round).
+    // payloads is sized to num_parties + 1 and indexed by party id (slot 0 and self stay untouched).
+    // missing lists the peers that did not deliver in time. Returns true if every peer delivered.
+    // A peer's extra messages beyond the first are kept for the next receive call.
+    bool routerReceiveFromAll(std::vector<zmq::message_t>& payloads, std::vector<int>& missing, int timeoutMs = -1);
+
+    // Round-tagged messaging. Each message carries a small header frame (session, round, seq; see
+    // WireFormat.h) ahead of the payload, so a fast peer's round k+1 message is never mistaken
+    // for round k and parties can keep several rounds in flight without a barrier per round.
+    // Tagged messages are buffered per (peer, round) and never surface through the untagged receives.
+    // Messages whose session differs from ours are dropped on receive.
+    void setSession(uint32_t session) noexcept;
+    uint32_t getSession() const noexcept { return session_; }
+    bool dealerSendRound(int peerId, uint32_t round, const std::string& payload);
+    bool dealerSendRound(int peerId, uint32_t round, zmq::message_t&& payload);
+    // Receive peerId's message for round; messages for other (peer, round) keys are buffered.
+    bool routerReceiveRound(int peerId, uint32_t round, zmq::message_t& payload, int timeoutMs = -1);
+    // Gather round's message from every peer under one deadline (see routerReceiveFromAll).
+    bool routerReceiveRoundFromAll(uint32_t round, std::vector<zmq::message_t>& payloads, std::vector<int>& missing, int timeoutMs = -1);
+
+    // Chunked streams. A large payload goes out as independent chunk messages (chunk size set by
+    // setChunkSize, default 64 KiB) tagged with (session, stream id, index, count, offset, total),
+    // so the receiver can consume - or a relay forward - chunk k while chunk k+1 is on the wire.
+    // Chunks reference the sender's buffer; the payload is not copied per chunk.
+    // Chunks are buffered per (peer, stream id); stream ids are chosen by the protocol.
+    struct StreamChunk {
+        uint32_t index = 0;
+        uint32_t count = 0;
+        uint64_t offset = 0;
+        uint64_t total = 0;
+        zmq::message_t data;
+        bool last() const noexcept { return index + 1 == count; }
+    };
+    using ChunkHandler = std::function<void(const StreamChunk& chunk)>;
+    void setChunkSize(size_t bytes) noexcept { chunkSize_ = bytes > 0 ? bytes : 1; }
+    size_t getChunkSize() const noexcept { return chunkSize_; }
+    bool streamSend(int peerId, uint32_t streamId, const std::string& payload);
+    bool streamSend(int peerId, uint32_t streamId, zmq::message_t&& payload);
+    // Next chunk of peerId's stream. timeoutMs bounds the wait for this chunk.
+    bool streamReceiveChunk(int peerId, uint32_t streamId, StreamChunk& chunk, int timeoutMs = -1);
+    // Call onChunk for every chunk of the stream in order, returning after the last one.
+    // timeoutMs bounds the wait for each chunk.
+    bool streamReceive(int peerId, uint32_t streamId, const ChunkHandler& onChunk, int timeoutMs = -1);
+    // Reassemble the whole stream into payload.
+    bool streamReceive(int peerId, uint32_t streamId, zmq::message_t& payload, int timeoutMs = -1);
+    // Receive a stream from fromPeer and forward each chunk to every peer in forwardTo as soon as
+    // it arrives (before onChunk runs, if given), so a relay adds one chunk time instead of a
+    // full store-and-forward. Forwarded chunks share the received buffer.
+    bool streamRelay(int fromPeer, uint32_t streamId, const std::vector<int>& forwardTo,
+                     const ChunkHandler& onChunk = nullptr, int timeoutMs = -1);
+
+    // Small-message coalescing. queue() appends a length-prefixed record to a per-peer buffer and
+    // flush(peer)/flushAll() send each non-empty buffer as one DEALER message, so N tiny sends
+    // become one wire message per peer per round. A buffer that reaches the coalescing threshold
+    // (default 64 KiB) is flushed by queue() itself. Receivers unpack with MessageCursor. A failed
+    // flush (false) keeps the buffer, so calling flush again later retries every queued record;
+    // queue() returning false after appending means only its flush failed.
+    void setCoalesceThreshold(size_t bytes) noexcept { coalesceThreshold_ = bytes; }
+    size_t getCoalesceThreshold() const noexcept { return coalesceThreshold_; }
+    bool queue(int peerId, const void* data, size_t len);
+    bool queue(int peerId, const std::string& bytes) { return queue(peerId, bytes.data(), bytes.size()); }
+    bool flush(int peerId);
+    bool flushAll();
+
+    // Typed share vectors. Wire format: the values back to back as little-endian uint64, encoded
+    // directly into the zmq message memory (no text formatting, no intermediate string).
+    bool sendVec(int peerId, const uint64_t* data, size_t count);
+    bool sendVec(int peerId, const std::vector<uint64_t>& values) { return sendVec(peerId, values.data(), values.size()); }
+    // Receive peerId's next message into out (resized to fit). Fails if the payload is not a whole
+    // number of uint64 values. Messages from other peers are kept, as in routerReceiveFrom.
+    bool recvVec(int peerId, std::vector<uint64_t>& out, int timeoutMs = -1);
+
+    // Bit-packed share vectors for small fields (see FieldPacking.h): each value takes `bits` bits,
+    // e.g. fieldpack::bitsFor(8380417) = 23 instead of 64. Wire format: [count: u64 LE][packed bits].
+    // Values must already be reduced below 2^bits; both sides must agree on bits.
+    bool sendPacked(int peerId, const uint64_t* data, size_t count, unsigned bits);
+    bool sendPacked(int peerId, const std::vector<uint64_t>& values, unsigned bits) { return sendPacked(peerId, values.data(), values.size(), bits); }
+    bool recvPacked(int peerId, std::vector<uint64_t>& out, unsigned bits, int timeoutMs = -1);
+
+    // Credit-based flow control. With a budget B > 0, at most B payload bytes may be outstanding
+    // toward each peer: sent over our DEALER but not yet handed to the peer's application by a
+    // receive call. Receivers return credit in Credit control frames each time they have consumed
+    // B/2 bytes from a peer, so buffering for a peer stays within B on both ends instead of
+    // growing inside libzmq. A message larger than B goes out only when nothing is outstanding.
+    // All parties must set the same budget before their first send. 0 (the default) disables it.
+    // The bool send calls wait up to the credit timeout (default 1000 ms, like sndtimeo) and then
+    // fail without sending; nothing is dropped or queued on the caller's behalf.
+    enum class SendResult { Ok, WouldBlock, Error };
+    void setFlowBudget(size_t bytesPerPeer);
+    size_t getFlowBudget() const noexcept { return flowBudget_; }
+    void setCreditTimeout(int timeoutMs) noexcept { creditTimeoutMs_ = timeoutMs; }
+    // Never waits. On WouldBlock the payload is left untouched so the caller can retry later,
+    // e.g. after waitForCredit.
+    SendResult trySendTo(int peerId, zmq::message_t&& payload);
+    // Wait until `bytes` may be sent to peerId. Incoming traffic read meanwhile is buffered for
+    // the receive calls as usual. timeoutMs < 0 waits forever.
+    bool waitForCredit(int peerId, size_t bytes, int timeoutMs = -1);
+    // Bytes that may still be sent to peerId (the full budget when flow control is off)
+    int64_t availableCredit(int peerId) const noexcept;
 
     // Router sends a single-frame payload to a specific dealer identity.
     bool routerSend(const std::string& toIdentity, const std::string& payload);
@@ -53,10 +223,80 @@ public:
     bool dealerSendTo(int peerId, zmq::message_t&& payload);
 
     // PUB/SUB API
-    // Publish payload under topic = std::to_string(id). Fire-and-forget, non-blocking.
+    // Publish payload as [topic][payload] with topic = std::to_string(id). Fire-and-forget, non-blocking.
     bool pubBroadcast(const std::string& payload);
+    bool pubBroadcast(zmq::message_t&& payload);
     // Receive one PUB/SUB message: returns publisher id (topic) and payload. timeoutMs < 0 blocks.
     bool subReceive(std::string& fromPublisherId, std::string& payload, int timeoutMs = -1);
+    // Zero-copy variant: moves the payload frame out and reports the publisher's party id.
+    bool subReceive(int& fromPublisherId, zmq::message_t& payload, int timeoutMs = -1);
+    // View variant: calls onMessage(int fromPublisherId, const void* data, size_t size).
+    template <typename F>
+    bool subReceiveView(F&& onMessage, int timeoutMs = -1) {
+        int fromId = -1;
+        if (!subReceive(fromId, viewScratch_, timeoutMs)) return false;
+        onMessage(fromId, static_cast<const void*>(viewScratch_.data()), viewScratch_.size());
+        return true;
+    }
+
+    // Readiness wait for event loops: block until the ROUTER or SUB socket has input, fd (if >= 0)
+    // is readable, or timeoutMs passes (< 0 waits forever). Returns a mask of InboundReady bits.
+    // ROUTER messages already buffered by earlier receives count as ROUTER input.
+    enum InboundReady : int { kRouterReady = 1, kSubReady = 2, kFdReady = 4 };
+    int waitInbound(int timeoutMs, int fd = -1);
+
+    // Handlers for poll(). A source whose handler is unset is not polled; its messages stay queued.
+    // The message may be moved out by the handler.
+    struct PollHandlers {
+        std::function<void(int fromId, zmq::message_t& payload)> onRouter;         // untagged ROUTER traffic
+        std::function<void(int publisherId, zmq::message_t& payload)> onSub;       // PUB/SUB broadcasts
+        std::function<void(int peerId, zmq::message_t& payload)> onDealerReply;    // routerSend replies on our DEALERs
+    };
+    // Serve all inbound traffic from one thread: a single zmq::poll over the ROUTER, SUB and
+    // per-peer DEALER sockets under one deadline (timeoutMs < 0 waits forever), with no per-call
+    // setsockopt. Once anything is ready, every message queued on a ready socket is dispatched.
+    // Each message is off the internal queues before its handler runs, so a handler may move it
+    // out or call other receive functions.
+    // Returns the number of messages dispatched (0 on timeout). Returns at once when no set-up
+    // socket has a matching handler, since nothing could end an unbounded wait.
+    int poll(const PollHandlers& handlers, int timeoutMs = -1);
+
+    // Per-peer metrics (see PeerMetrics.h): messages, bytes, send failures, inbound queue depth,
+    // send latency and receive wait for DEALER/ROUTER (or mesh) traffic, plus SUB receives per
+    // publisher. Recorded with relaxed atomics on the send/receive paths, so another thread may
+    // take snapshots while this one runs. Needs the num_parties constructor (empty otherwise).
+    std::vector<PeerMetrics> metricsSnapshot() const;
+    // Prometheus text format, e.g. for a scraper or a textfile collector
+    std::string metricsText() const { return formatMetricsText(id, metricsSnapshot()); }
+    void resetMetrics() noexcept;
+    // Skip the clock reads and counter updates (on by default). Call before any traffic.
+    void setMetricsEnabled(bool enabled) noexcept { metricsEnabled_ = enabled; }
+
+    // Low-latency mode for dedicated hosts. With a spin budget, a receive that finds nothing
+    // queued keeps retrying non-blocking reads for up to spinUs microseconds before it sleeps in
+    // zmq::poll, trading a busy core for skipping the scheduler wakeup. 0 (default) never spins.
+    void setBusyPoll(int spinUs) noexcept { spinUs_ = spinUs > 0 ? spinUs : 0; }
+    int getBusyPoll() const noexcept { return spinUs_; }
+    // Pin the context's I/O threads to cores. Call after setTransport/useContext and before any
+    // setUp*: libzmq applies it only to I/O threads it has not started yet, so a context other
+    // sockets already use keeps its placement. False if libzmq lacks ZMQ_THREAD_AFFINITY_CPU_ADD.
+    bool setIoThreadCores(const std::vector<int>& cores);
+    // Cores for the dealerSendToAllParallel sender lanes (lane k on cores[k % size]). Call before
+    // the first parallel send.
+    void setWorkerCores(std::vector<int> cores) { workerCores_ = std::move(cores); }
+
+    // Send payloads come from a size-class pool (see BufferPool.h) and go to ZeroMQ without a
+    // copy; its I/O thread hands each buffer back once the message is on the wire, so steady-state
+    // sends reuse the same blocks instead of calling malloc/free per message. Payloads up to
+    // kInlineMessage bytes are stored inside the zmq message itself and never touch the pool.
+    static constexpr size_t kInlineMessage = 32;
+    // An uninitialized message of `bytes` to fill and pass to any send taking a zmq::message_t&&
+    zmq::message_t allocMessage(size_t bytes);
+    // A message holding a copy of data
+    zmq::message_t copyMessage(const void* data, size_t bytes);
+    BufferPool& bufferPool() noexcept { return pool_; }
+    // Off: messages are allocated by libzmq as before (on by default)
+    void setBufferPoolEnabled(bool enabled) noexcept { poolEnabled_ = enabled; }
 
 private:
     int id;
@@ -64,8 +304,17 @@ private:
     std::string address;
     int num_parties = 0; // optional, for informational purposes
 
-    // Persistent ZeroMQ context and sockets (created on demand)
-    std::unique_ptr<zmq::context_t> context_;
+    // Persistent ZeroMQ context and sockets (created on demand). The context may be shared with
+    // other Communicators (useContext / processContext); it is declared first so it outlives the sockets.
+    std::shared_ptr<zmq::context_t> context_;
+    Transport transport_ = Transport::Tcp;
+    void ensureContext();
+    // Bind sock on `port` with the endpoints the transport calls for, registering in-process binds
+    void bindEndpoints(zmq::socket_t& sock, int port);
+    // Endpoint to connect to for a peer socket bound on `port`
+    std::string connectEndpoint(int port) const;
+    std::vector<int> boundPorts_; // ports registered for Auto discovery, released in the destructor
+    std::unordered_map<int, std::string> dealerEndpoints_;
     std::unique_ptr<zmq::socket_t> router_; // ROUTER socket for incoming messages
     std::unique_ptr<zmq::socket_t> pub_;    // PUB socket for broadcast
     std::unique_ptr<zmq::socket_t> sub_;    // SUB socket to receive broadcasts
@@ -73,13 +322,134 @@ private:
     // Optional: dedicated DEALER sockets per peer for targeted sends.
     std::unordered_map<int, std::unique_ptr<zmq::socket_t>> perPeerDealer_;
 
-    // Reusable worker resources for parallel dealer sends
-    std::vector<std::thread> workerThreads_;
-    // Use a byte vector instead of vector<bool> to avoid bit-packing data races
-    std::vector<uint8_t> workerResults_;
-    void joinAndClearWorkers() noexcept;
+    // Persistent per-peer sender lanes for dealerSendToAllParallel (created lazily).
+    // Declared after the sockets so its threads are joined before the sockets close.
+    std::unique_ptr<PeerSendPool> sendPool_;
 
     std::vector<int> ids;
+
+    using Clock = std::chrono::steady_clock;
+
+    // Shared receive paths: pull one [identity][payload] (ROUTER) or [topic][payload] (SUB) message.
+    // readRouterFrames also accepts [identity][header][payload]; header is left empty otherwise.
+    bool readRouterFrames(zmq::message_t& identity, zmq::message_t& header, zmq::message_t& payload, zmq::recv_flags flags);
+    bool readSubFrames(zmq::message_t& topic, zmq::message_t& payload, zmq::recv_flags flags);
+    bool recvSubFrames(zmq::message_t& topic, zmq::message_t& payload, int timeoutMs);
+    // timeoutMs < 0 maps to time_point::max(), i.e. wait forever.
+    static Clock::time_point deadlineAfter(int timeoutMs);
+    // Wait until the ROUTER is readable or the deadline passes.
+    bool pollRouter(Clock::time_point deadline);
+    // waitInbound; countBuffered = false reports and waits on the sockets alone, ignoring
+    // messages already parked in pendingRouter_/pendingSub_
+    int waitInbound(int timeoutMs, int fd, bool countBuffered);
+    // zmq::poll that first spins with zero timeouts for the busy-poll budget (setBusyPoll)
+    int spinPoll(zmq::pollitem_t* items, size_t count, long waitMs);
+    // Read one message off the ROUTER (waiting up to deadline). Untagged messages are appended to
+    // pendingRouter_; header-tagged ones are routed by handleTaggedMessage.
+    enum class Pumped { Nothing, Untagged, Tagged };
+    Pumped pumpRouter(Clock::time_point deadline);
+    void handleTaggedMessage(int fromId, const zmq::message_t& header, zmq::message_t&& payload);
+    // Send [header][payload] to a peer through its DEALER.
+    bool sendTagged(int peerId, zmq::message_t& header, zmq::message_t&& payload);
+    // Gather bookkeeping shared by the untagged and round-tagged gathers
+    size_t resetGatherSlots(size_t slots);
+    void collectMissing(size_t slots, std::vector<int>& missing) const;
+
+    // Reused by the *View receive helpers so they never allocate a message per call
+    zmq::message_t viewScratch_;
+    // ROUTER messages already pulled off the socket but not yet asked for
+    struct PendingRouter {
+        int from;              // party id parsed from the routing id, -1 if it is not one
+        zmq::message_t payload;
+        std::string identity;  // raw routing id, kept only when std::to_string(from) would not give it back
+    };
+    std::deque<PendingRouter> pendingRouter_;
+    // Per-party "already gathered" flags reused across routerReceiveFromAll calls
+    std::vector<uint8_t> gatherFilled_;
+    // Scratch frames reused by pumpRouter
+    zmq::message_t identityScratch_;
+    zmq::message_t headerScratch_;
+    // Cached poll set for poll(): one item per socket; pollSources_ holds 0 (ROUTER), -1 (SUB) or
+    // the peer id of a DEALER. Rebuilt lazily after any setUp* call adds a socket.
+    std::vector<zmq::pollitem_t> pollItems_;
+    std::vector<int> pollSources_;
+    bool pollSetDirty_ = true;
+    void rebuildPollSet();
+    // Last rcvtimeo applied to the SUB socket, so unchanged timeouts skip the setsockopt
+    int subRcvTimeo_ = -1;
+
+    // Backs allocMessage/copyMessage. Blocks keep the pool's core alive, so messages still queued
+    // in ZeroMQ when this Communicator is destroyed are freed safely later.
+    BufferPool pool_;
+    bool poolEnabled_ = true;
+
+    // Per-peer coalescing buffers indexed by party id (capacity is kept across flushes)
+    std::vector<std::vector<uint8_t>> coalesce_;
+    size_t coalesceThreshold_ = 64 * 1024;
+
+    // Round-tagged messaging state
+    uint32_t session_ = 0;
+    std::vector<uint32_t> roundSendSeq_; // next seq per destination party id
+    // Reorder buffer: tagged messages keyed by (sender id, round), FIFO within a key
+    std::map<std::pair<int, uint32_t>, std::deque<zmq::message_t>> reorder_;
+
+    // Flow control state, indexed by party id (see setFlowBudget)
+    size_t flowBudget_ = 0;
+    int creditTimeoutMs_ = 1000;
+    int spinUs_ = 0;
+    std::vector<int> workerCores_;
+    std::vector<int64_t> sendCredit_; // bytes we may still send to each peer
+    std::vector<uint64_t> consumed_;  // bytes consumed from each peer since our last grant
+    bool hasCredit(int peerId, size_t bytes) const noexcept;
+    // Wait for and take credit for one message; refundCredit returns it if the send failed
+    bool acquireCredit(int peerId, size_t bytes, Clock::time_point deadline);
+    void refundCredit(int peerId, size_t bytes) noexcept;
+    // Account for a message handed to the application; grants credit back to the sender
+    void noteConsumed(int fromId, size_t bytes);
+    void noteGathered(const std::vector<zmq::message_t>& payloads, size_t slots);
+    // A Round or Chunk frame dropped for carrying another session was charged against its sender's
+    // budget all the same; grant it back at once, tagged with that session so the sender accepts it
+    void returnStaleCredit(int fromId, uint32_t session, size_t bytes);
+    // Sends without flow-control accounting
+    bool rawDealerSend(int peerId, zmq::message_t&& payload);
+    // Mesh mode: send [peer routing id][header][payload] (header may be null) over router_
+    // Retries while the peer is unreachable until deadline (time_point::min() = one attempt).
+    bool meshSend(int peerId, zmq::message_t* header, zmq::message_t&& payload, Clock::time_point deadline);
+    bool mesh_ = false;
+    std::vector<std::string> meshIds_; // routing id per party id
+
+    // Readiness handshake state per party id (see awaitMeshReady)
+    enum : uint8_t { kHelloFrom = 1, kAckFrom = 2, kBeaconFrom = 4, kSubReadyFrom = 8, kHelloSent = 16 };
+    std::vector<uint8_t> meshState_;
+    // SUB messages read while awaiting readiness, handed out first by the SUB receives: (topic, payload)
+    std::deque<std::pair<zmq::message_t, zmq::message_t>> pendingSub_;
+    // Send a header-only control frame of the given wire::FrameKind (once: no retry in mesh mode)
+    bool sendControl(int peerId, uint8_t kind, bool once);
+    void publishBeacon();
+    void handleBeacon(int fromId, const zmq::message_t& header);
+    bool knownPeer(int peerId) const noexcept { return peerId > 0 && static_cast<size_t>(peerId) <= ids.size() && peerId != id; }
+    bool rawSendTagged(int peerId, zmq::message_t& header, zmq::message_t&& payload);
+
+    // Per-peer metrics indexed by party id; allocated once in the constructor so lanes and
+    // scrapers never see it move
+    std::unique_ptr<PeerCounters[]> metrics_;
+    size_t metricsSlots_ = 0;
+    bool metricsEnabled_ = true;
+    // Start of the receive call that is pumping the ROUTER (min() outside receive calls)
+    Clock::time_point recvStart_ = Clock::time_point::min();
+    struct ReceiveTimer;
+    PeerCounters* peerCounters(int peerId) const noexcept {
+        return metricsEnabled_ && peerId > 0 && static_cast<size_t>(peerId) < metricsSlots_ ? &metrics_[peerId] : nullptr;
+    }
+    Clock::time_point metricsNow() const noexcept { return metricsEnabled_ ? Clock::now() : Clock::time_point::min(); }
+    void noteSent(int peerId, size_t bytes, bool ok, Clock::time_point started) noexcept;
+    void noteArrived(int fromId) noexcept;
+    void noteSubReceived(int fromId, size_t bytes, Clock::time_point started) noexcept;
+
+    // Chunked streams: chunks keyed by (sender id, stream id), in arrival order
+    size_t chunkSize_ = 64 * 1024;
+    std::map<std::pair<int, uint32_t>, std::deque<StreamChunk>> streams_;
+    bool sendChunk(int peerId, uint32_t streamId, const StreamChunk& chunk, zmq::message_t&& data);
 };
 
 #endif // COMMUNICATOR_H
\ No newline at end of file
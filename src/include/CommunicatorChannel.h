@@ -0,0 +1,43 @@
+#ifndef COMMUNICATOR_CHANNEL_H
+#define COMMUNICATOR_CHANNEL_H
+
+#include "Channel.h"
+#include "Communicator.h"
+#include <cstring>
+
+// Channel adapter (see Channel.h) over a Communicator's per-peer DEALERs and its ROUTER.
+// comm must know the party count and have setUpRouterDealer (or setUpMesh) done. Each send is
+// one zmq message and goes out immediately, so flush has nothing to do; recv returns false on
+// timeout or when the next message from peer is not exactly len bytes.
+class CommunicatorChannel {
+public:
+    // timeoutMs bounds each recv; < 0 waits forever
+    explicit CommunicatorChannel(Communicator& comm, int timeoutMs = -1) noexcept
+        : comm_(comm), timeoutMs_(timeoutMs) {}
+
+    int party() const noexcept { return comm_.getId(); }
+    int parties() const noexcept { return comm_.getNumParties(); }
+
+    bool send(int peer, const void* data, size_t len) {
+        return comm_.dealerSendTo(peer, comm_.copyMessage(data, len));
+    }
+    bool recv(int peer, void* data, size_t len) {
+        if (!comm_.routerReceiveFrom(peer, msg_, timeoutMs_) || msg_.size() != len) return false;
+        if (len) std::memcpy(data, msg_.data(), len);
+        return true;
+    }
+    // One copy of the payload, shared by every peer's send
+    bool broadcast(const void* data, size_t len) {
+        return comm_.dealerSendToAll(comm_.copyMessage(data, len));
+    }
+    void flush(int = 0) noexcept {}
+
+    Communicator& communicator() noexcept { return comm_; }
+
+private:
+    Communicator& comm_;
+    int timeoutMs_;
+    zmq::message_t msg_;
+};
+
+#endif // COMMUNICATOR_CHANNEL_H
@@ -0,0 +1,40 @@
+#ifndef CPU_AFFINITY_H
+#define CPU_AFFINITY_H
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+// Thread-to-core pinning for the low-latency mode. On a dedicated host, pinning the party
+// thread, the ZMQ I/O threads (Communicator::setIoThreadCores) and worker threads to separate
+// cores keeps a busy-polling receiver from being migrated or sharing a core with its own I/O.
+// Linux only: elsewhere the pin calls do nothing and return false.
+namespace cpu {
+
+// Restrict the calling thread to cores (or to the single core). False if cores is empty, a core
+// does not exist, or the platform has no affinity API.
+bool pinCurrentThread(const std::vector<int>& cores);
+inline bool pinCurrentThread(int core) { return pinCurrentThread(std::vector<int>{core}); }
+bool pinThread(std::thread& t, const std::vector<int>& cores);
+inline bool pinThread(std::thread& t, int core) { return pinThread(t, std::vector<int>{core}); }
+
+// Parse a Linux-style core list such as "0,2,4-7". Empty on malformed input or a core number
+// beyond what the affinity mask can hold (CPU_SETSIZE).
+std::vector<int> parseCoreList(const std::string& spec);
+
+// Spin-wait hint for busy-poll loops
+inline void relax() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+} // namespace cpu
+
+#endif // CPU_AFFINITY_H
@@ -0,0 +1,29 @@
+#ifndef FIELD_PACKING_H
+#define FIELD_PACKING_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Dense bit-packed wire encoding for elements of small prime fields.
+// count values of `bits` bits each are laid out LSB-first as one little-endian bit stream,
+// so 23-bit elements mod Q = 8380417 take 23 bits on the wire instead of 64.
+namespace fieldpack {
+
+// Smallest width that holds every value in [0, modulus): ceil(log2(modulus)), at least 1.
+unsigned bitsFor(uint64_t modulus) noexcept;
+
+// Bytes needed for count values of `bits` bits each.
+inline size_t packedSize(size_t count, unsigned bits) noexcept {
+    return (count * bits + 7) / 8;
+}
+
+// Pack count values into out (packedSize(count, bits) bytes). Bits above `bits` are ignored,
+// so callers must reduce values first. 1 <= bits <= 64.
+void pack(const uint64_t* in, size_t count, unsigned bits, uint8_t* out) noexcept;
+
+// Inverse of pack: read count values of `bits` bits from in.
+void unpack(const uint8_t* in, size_t count, unsigned bits, uint64_t* out) noexcept;
+
+} // namespace fieldpack
+
+#endif // FIELD_PACKING_H
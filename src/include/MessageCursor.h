@@ -0,0 +1,44 @@
+#ifndef MESSAGE_CURSOR_H
+#define MESSAGE_CURSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <zmq.hpp>
+#include "WireFormat.h"
+
+// Reads the records of a coalesced message produced by Communicator::queue()/flush().
+// Layout: repeated [length: u32 little-endian][length bytes]. Records are views into the
+// message and stay valid as long as the message does.
+class MessageCursor {
+public:
+    MessageCursor(const void* data, size_t size) noexcept
+        : p_(static_cast<const uint8_t*>(data)), end_(static_cast<const uint8_t*>(data) + size) {}
+    explicit MessageCursor(const zmq::message_t& msg) noexcept : MessageCursor(msg.data(), msg.size()) {}
+
+    // Advance to the next record. Returns false at the end or if the remaining bytes are truncated.
+    bool next(const void*& data, size_t& len) noexcept {
+        if (static_cast<size_t>(end_ - p_) < kRecordPrefix) return false;
+        const size_t n = wire::loadLE32(p_);
+        if (static_cast<size_t>(end_ - p_) - kRecordPrefix < n) {
+            truncated_ = true;
+            return false;
+        }
+        data = p_ + kRecordPrefix;
+        len = n;
+        p_ += kRecordPrefix + n;
+        return true;
+    }
+
+    bool atEnd() const noexcept { return p_ == end_; }
+    // True if next() stopped on a record that claims more bytes than the message holds.
+    bool truncated() const noexcept { return truncated_; }
+
+    static constexpr size_t kRecordPrefix = 4;
+
+private:
+    const uint8_t* p_;
+    const uint8_t* end_;
+    bool truncated_ = false;
+};
+
+#endif // MESSAGE_CURSOR_H
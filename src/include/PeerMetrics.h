@@ -0,0 +1,92 @@
+#ifndef PEER_METRICS_H
+#define PEER_METRICS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Lock-free latency histogram in nanoseconds, HDR style: values below 2^kSubBits get one bucket
+// each, above that every power of two is split into 2^kSubBits linear sub-buckets, so a bucket
+// is never wider than 1/8 of its value (12.5% worst-case quantile error). record() is a few
+// relaxed atomic adds and may be called from any thread; values past ~18 minutes saturate.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBits = 3;
+    static constexpr unsigned kMaxExponent = 40; // 2^40 ns ~ 18 min
+    static constexpr size_t kBuckets = (size_t(kMaxExponent - kSubBits) + 2) << kSubBits;
+
+    struct Snapshot {
+        uint64_t count = 0;
+        uint64_t sumNs = 0;
+        uint64_t maxNs = 0;
+        std::vector<uint64_t> buckets; // kBuckets counts, see bucketOf
+        // Upper bound of the bucket holding the q-th quantile (0 <= q <= 1), capped at maxNs; 0 if empty
+        uint64_t percentile(double q) const noexcept;
+        double meanNs() const noexcept { return count ? static_cast<double>(sumNs) / count : 0.0; }
+    };
+
+    void record(uint64_t ns) noexcept {
+        buckets_[bucketOf(ns)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(ns, std::memory_order_relaxed);
+        uint64_t seen = max_.load(std::memory_order_relaxed);
+        while (ns > seen && !max_.compare_exchange_weak(seen, ns, std::memory_order_relaxed)) {}
+    }
+    // Counters are read one by one, so a snapshot taken during record() calls may be off by the
+    // samples in flight; it never tears a single counter.
+    Snapshot snapshot() const;
+    void reset() noexcept;
+
+    static size_t bucketOf(uint64_t ns) noexcept {
+        if (ns < (uint64_t(1) << kSubBits)) return static_cast<size_t>(ns);
+        unsigned e = 63u - static_cast<unsigned>(__builtin_clzll(ns));
+        if (e > kMaxExponent) return kBuckets - 1;
+        const size_t sub = static_cast<size_t>(ns >> (e - kSubBits)) & ((size_t(1) << kSubBits) - 1);
+        return (size_t(e - kSubBits + 1) << kSubBits) + sub;
+    }
+    // Largest value that lands in bucket b
+    static uint64_t bucketUpperBound(size_t b) noexcept;
+
+private:
+    std::atomic<uint64_t> buckets_[kBuckets] = {};
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> max_{0};
+};
+
+// Live per-peer counters owned by Communicator. Every field is a relaxed atomic so sender lanes
+// and a scraping thread can touch them while the owning thread runs.
+struct PeerCounters {
+    std::atomic<uint64_t> messagesSent{0};
+    std::atomic<uint64_t> bytesSent{0};
+    std::atomic<uint64_t> sendFailures{0};    // sends that returned false (EAGAIN under dontwait, no credit, unreachable)
+    std::atomic<uint64_t> messagesArrived{0}; // read off the socket, buffered or handed out
+    std::atomic<uint64_t> messagesReceived{0}; // handed to the application
+    std::atomic<uint64_t> bytesReceived{0};
+    LatencyHistogram sendLatency; // time spent inside one send call
+    LatencyHistogram recvWait;    // from the start of the receive call that read a message to its arrival
+
+    void reset() noexcept;
+};
+
+// Point-in-time copy of one peer's counters
+struct PeerMetrics {
+    int peer = 0;
+    uint64_t messagesSent = 0;
+    uint64_t bytesSent = 0;
+    uint64_t sendFailures = 0;
+    uint64_t messagesReceived = 0;
+    uint64_t bytesReceived = 0;
+    uint64_t queueDepth = 0; // arrived from this peer but not yet handed to the application
+    LatencyHistogram::Snapshot sendLatency;
+    LatencyHistogram::Snapshot recvWait;
+};
+
+PeerMetrics snapshotPeer(int peer, const PeerCounters& counters);
+
+// Prometheus text exposition (version 0.0.4) of one party's per-peer metrics: counters as
+// sc_*_total, latencies as summaries with 0.5/0.9/0.99/0.999 quantiles, all labelled
+// {party="<self>",peer="<id>"}. Suitable for a node-exporter textfile collector or a local scraper.
+std::string formatMetricsText(int selfId, const std::vector<PeerMetrics>& peers);
+
+#endif // PEER_METRICS_H
@@ -0,0 +1,54 @@
+#ifndef PEER_SEND_POOL_H
+#define PEER_SEND_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <zmq.hpp>
+
+// Long-lived sender threads for fan-out sends, one lane per peer.
+// A lane is the only thread touching its peer's DEALER socket while a fan-out is in flight,
+// so a broadcast costs one queue push per peer instead of one thread spawn per peer.
+// Lanes receive zmq_msg_copy shares of one message, so the payload bytes are never duplicated.
+class PeerSendPool {
+public:
+    // Called on the lane's thread to deliver one message to one peer.
+    using SendFn = std::function<bool(int peerId, zmq::message_t&& payload)>;
+
+    // cores, if given, pins lane k to cores[k % cores.size()] (see CpuAffinity.h)
+    PeerSendPool(const std::vector<int>& peerIds, SendFn send, const std::vector<int>& cores = {});
+    ~PeerSendPool();
+
+    PeerSendPool(const PeerSendPool&) = delete;
+    PeerSendPool& operator=(const PeerSendPool&) = delete;
+
+    // Hand a reference-counted share of payload to every lane and block until all lanes are done.
+    // Returns true only if every per-peer send succeeded. Not reentrant: one fan-out at a time.
+    bool sendToAll(zmq::message_t& payload);
+
+    size_t laneCount() const noexcept { return lanes_.size(); }
+
+private:
+    struct Lane;
+
+    // Reusable completion barrier for one fan-out: lanes count down, the caller waits for zero.
+    struct Completion {
+        std::atomic<int> remaining{0};
+        std::atomic<bool> failed{false};
+        std::atomic<bool> waiterParked{false};
+        std::mutex m;
+        std::condition_variable cv;
+    };
+
+    void runLane(Lane& lane);
+    void finishJob(bool ok) noexcept;
+
+    SendFn send_;
+    Completion done_;
+    std::vector<std::unique_ptr<Lane>> lanes_;
+};
+
+#endif // PEER_SEND_POOL_H
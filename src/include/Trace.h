@@ -0,0 +1,197 @@
+#ifndef SC_TRACE_H
+#define SC_TRACE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Send/receive event tracer, exported as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+// Compiled in only with SC_ENABLE_TRACING (CMake option of the same name); otherwise the
+// SC_TRACE_* macros expand to nothing and the hot paths carry no trace code at all.
+//
+// Each thread appends to its own fixed-size ring (single producer, no locks, oldest events
+// overwritten), registered once on the thread's first event. Events carry the party id, so the
+// export has one track (process) per party with a lane per thread; a receive's duration is how
+// long that party waited on the peer. The trace is written at exit to $SC_TRACE_FILE if set, or
+// explicitly with sctrace::writeChromeTrace once traffic has stopped.
+namespace sctrace {
+
+enum class Op : uint8_t { Send, Recv, Publish, SubRecv, NetSend, NetRecv };
+
+inline const char* opName(Op op) noexcept {
+    switch (op) {
+    case Op::Send: return "send";
+    case Op::Recv: return "recv";
+    case Op::Publish: return "publish";
+    case Op::SubRecv: return "subRecv";
+    case Op::NetSend: return "netSend";
+    case Op::NetRecv: return "netRecv";
+    }
+    return "?";
+}
+
+struct Event {
+    uint64_t startNs = 0; // since the tracer's epoch
+    uint64_t durNs = 0;
+    uint64_t bytes = 0;
+    int32_t party = 0;
+    int32_t peer = -1;    // -1: unknown or all peers
+    Op op = Op::Send;
+};
+
+class ThreadRing {
+public:
+    static constexpr size_t kCapacity = size_t(1) << 15; // events kept per thread
+
+    explicit ThreadRing(uint32_t tid) : tid_(tid), events_(new Event[kCapacity]) {}
+
+    void push(const Event& e) noexcept {
+        const uint64_t n = written_.load(std::memory_order_relaxed);
+        events_[n & (kCapacity - 1)] = e;
+        written_.store(n + 1, std::memory_order_release);
+    }
+    uint32_t tid() const noexcept { return tid_; }
+    // Oldest to newest; only meaningful once this thread has stopped recording
+    template <typename F>
+    void forEach(F&& f) const {
+        const uint64_t n = written_.load(std::memory_order_acquire);
+        for (uint64_t i = n > kCapacity ? n - kCapacity : 0; i < n; ++i) f(events_[i & (kCapacity - 1)]);
+    }
+
+private:
+    const uint32_t tid_;
+    std::unique_ptr<Event[]> events_;
+    std::atomic<uint64_t> written_{0};
+};
+
+class Tracer {
+public:
+    static Tracer& instance() {
+        static Tracer t;
+        return t;
+    }
+
+    uint64_t now() const noexcept {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - epoch_).count());
+    }
+
+    // The calling thread's ring, created and registered on first use
+    ThreadRing& local() {
+        thread_local std::shared_ptr<ThreadRing> ring;
+        if (!ring) {
+            std::lock_guard<std::mutex> lk(m_);
+            ring = std::make_shared<ThreadRing>(static_cast<uint32_t>(rings_.size() + 1));
+            rings_.push_back(ring); // the registry keeps it alive after the thread exits
+        }
+        return *ring;
+    }
+
+    void writeChromeJson(std::ostream& out) {
+        std::vector<std::shared_ptr<ThreadRing>> rings;
+        {
+            std::lock_guard<std::mutex> lk(m_);
+            rings = rings_;
+        }
+        std::vector<int32_t> parties;
+        out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        bool first = true;
+        for (const auto& ring : rings) {
+            ring->forEach([&](const Event& e) {
+                out << (first ? "\n" : ",\n");
+                first = false;
+                // Complete ("X") events; Chrome timestamps are microseconds
+                out << "{\"name\":\"" << opName(e.op) << "\",\"ph\":\"X\",\"pid\":" << e.party
+                    << ",\"tid\":" << ring->tid() << ",\"ts\":" << e.startNs / 1000 << '.' << pad3(e.startNs % 1000)
+                    << ",\"dur\":" << e.durNs / 1000 << '.' << pad3(e.durNs % 1000)
+                    << ",\"args\":{\"peer\":" << e.peer << ",\"bytes\":" << e.bytes << "}}";
+                bool seen = false;
+                for (int32_t p : parties) seen = seen || p == e.party;
+                if (!seen) parties.push_back(e.party);
+            });
+        }
+        for (int32_t p : parties) {
+            out << (first ? "\n" : ",\n");
+            first = false;
+            out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << p << ",\"args\":{\"name\":\"party " << p << "\"}}";
+        }
+        out << "\n]}\n";
+    }
+
+    bool writeChromeTrace(const std::string& path) {
+        std::ofstream f(path);
+        if (!f) return false;
+        writeChromeJson(f);
+        return static_cast<bool>(f);
+    }
+
+    ~Tracer() {
+        if (const char* path = std::getenv("SC_TRACE_FILE")) writeChromeTrace(path);
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+    Tracer() : epoch_(Clock::now()) {}
+
+    static std::string pad3(uint64_t v) {
+        std::string s = std::to_string(v);
+        return std::string(3 - s.size(), '0') + s;
+    }
+
+    const Clock::time_point epoch_;
+    std::mutex m_;
+    std::vector<std::shared_ptr<ThreadRing>> rings_;
+};
+
+inline bool writeChromeTrace(const std::string& path) { return Tracer::instance().writeChromeTrace(path); }
+
+// Records one event spanning its lifetime. peer and bytes may be filled in before it ends,
+// e.g. once a receive knows who sent what.
+class Scope {
+public:
+    Scope(Op op, int party, int peer = -1, uint64_t bytes = 0) noexcept
+        : start_(Tracer::instance().now()), bytes_(bytes), party_(party), peer_(peer), op_(op) {}
+    ~Scope() {
+        Tracer& t = Tracer::instance();
+        Event e;
+        e.startNs = start_;
+        e.durNs = t.now() - start_;
+        e.bytes = bytes_;
+        e.party = party_;
+        e.peer = peer_;
+        e.op = op_;
+        t.local().push(e);
+    }
+    void set(int peer, uint64_t bytes) noexcept {
+        peer_ = peer;
+        bytes_ = bytes;
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    uint64_t start_;
+    uint64_t bytes_;
+    int party_;
+    int peer_;
+    Op op_;
+};
+
+} // namespace sctrace
+
+#ifdef SC_ENABLE_TRACING
+#define SC_TRACE_SCOPE(var, op, party, peer, bytes) ::sctrace::Scope var(::sctrace::Op::op, (party), (peer), (bytes))
+#define SC_TRACE_SET(var, peer, bytes) var.set((peer), (bytes))
+#else
+#define SC_TRACE_SCOPE(var, op, party, peer, bytes) ((void)0)
+#define SC_TRACE_SET(var, peer, bytes) ((void)0)
+#endif
+
+#endif // SC_TRACE_H
@@ -0,0 +1,168 @@
+#ifndef WIRE_FORMAT_H
+#define WIRE_FORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Fixed little-endian layouts for the small header frames Communicator may put in front of
+// a payload frame ([header][payload] on the wire). Byte 0 of every header is its FrameKind,
+// so a receiver can tell header types apart before decoding the rest.
+namespace wire {
+
+enum class FrameKind : uint8_t {
+    Round = 1, // session/round/sequence tag for round-based protocols
+    Chunk = 2, // one piece of a chunked stream
+    Credit = 3, // flow-control grant from a receiver back to a sender
+    Hello = 4,    // readiness probe over DEALER/ROUTER; also the PUB beacon
+    HelloAck = 5, // reply to a DEALER/ROUTER Hello
+    SubReady = 6, // "your PUB beacon reached my SUB", sent back over DEALER/ROUTER
+};
+
+inline void storeLE32(uint8_t* p, uint32_t v) noexcept {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+inline uint32_t loadLE32(const uint8_t* p) noexcept {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+inline void storeLE64(uint8_t* p, uint64_t v) noexcept {
+    storeLE32(p, static_cast<uint32_t>(v));
+    storeLE32(p + 4, static_cast<uint32_t>(v >> 32));
+}
+
+inline uint64_t loadLE64(const uint8_t* p) noexcept {
+    return static_cast<uint64_t>(loadLE32(p)) | (static_cast<uint64_t>(loadLE32(p + 4)) << 32);
+}
+
+// Bulk uint64 <-> little-endian bytes. On little-endian hosts this is a plain memcpy.
+inline void encodeU64LE(const uint64_t* in, size_t count, uint8_t* out) noexcept {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (count > 0) std::memcpy(out, in, count * sizeof(uint64_t));
+#else
+    for (size_t i = 0; i < count; ++i) storeLE64(out + i * 8, in[i]);
+#endif
+}
+
+inline void decodeU64LE(const uint8_t* in, size_t count, uint64_t* out) noexcept {
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if (count > 0) std::memcpy(out, in, count * sizeof(uint64_t));
+#else
+    for (size_t i = 0; i < count; ++i) out[i] = loadLE64(in + i * 8);
+#endif
+}
+
+// Returns the kind of a header frame, or 0 if it is too short to carry one.
+inline uint8_t headerKind(const void* data, size_t size) noexcept {
+    return size > 0 ? static_cast<const uint8_t*>(data)[0] : 0;
+}
+
+// Round tag: [kind:1][reserved:3][session:4][round:4][seq:4]
+struct RoundHeader {
+    uint32_t session = 0;
+    uint32_t round = 0;
+    // Per (sender, receiver) message counter. Informational only (e.g. for wire captures): the
+    // receiver does not check it, as ZeroMQ already delivers a pair's messages whole and in order.
+    uint32_t seq = 0;
+};
+constexpr size_t kRoundHeaderSize = 16;
+
+inline void encodeRoundHeader(const RoundHeader& h, uint8_t* out) noexcept {
+    out[0] = static_cast<uint8_t>(FrameKind::Round);
+    out[1] = out[2] = out[3] = 0;
+    storeLE32(out + 4, h.session);
+    storeLE32(out + 8, h.round);
+    storeLE32(out + 12, h.seq);
+}
+
+inline bool decodeRoundHeader(const void* data, size_t size, RoundHeader& out) noexcept {
+    const auto* p = static_cast<const uint8_t*>(data);
+    if (size != kRoundHeaderSize || p[0] != static_cast<uint8_t>(FrameKind::Round)) return false;
+    out.session = loadLE32(p + 4);
+    out.round = loadLE32(p + 8);
+    out.seq = loadLE32(p + 12);
+    return true;
+}
+
+// Stream chunk: [kind:1][reserved:3][session:4][stream:4][index:4][count:4][reserved:4][offset:8][total:8]
+struct ChunkHeader {
+    uint32_t session = 0;
+    uint32_t stream = 0;
+    uint32_t index = 0;  // 0-based chunk number
+    uint32_t count = 0;  // chunks in the stream (at least 1)
+    uint64_t offset = 0; // byte offset of this chunk in the whole payload
+    uint64_t total = 0;  // size of the whole payload
+};
+constexpr size_t kChunkHeaderSize = 40;
+
+inline void encodeChunkHeader(const ChunkHeader& h, uint8_t* out) noexcept {
+    out[0] = static_cast<uint8_t>(FrameKind::Chunk);
+    out[1] = out[2] = out[3] = 0;
+    storeLE32(out + 4, h.session);
+    storeLE32(out + 8, h.stream);
+    storeLE32(out + 12, h.index);
+    storeLE32(out + 16, h.count);
+    storeLE32(out + 20, 0);
+    storeLE64(out + 24, h.offset);
+    storeLE64(out + 32, h.total);
+}
+
+inline bool decodeChunkHeader(const void* data, size_t size, ChunkHeader& out) noexcept {
+    const auto* p = static_cast<const uint8_t*>(data);
+    if (size != kChunkHeaderSize || p[0] != static_cast<uint8_t>(FrameKind::Chunk)) return false;
+    out.session = loadLE32(p + 4);
+    out.stream = loadLE32(p + 8);
+    out.index = loadLE32(p + 12);
+    out.count = loadLE32(p + 16);
+    out.offset = loadLE64(p + 24);
+    out.total = loadLE64(p + 32);
+    return out.count > 0 && out.index < out.count;
+}
+
+// Flow-control credit: [kind:1][reserved:3][session:4][bytes:8]
+struct CreditHeader {
+    uint32_t session = 0;
+    uint64_t bytes = 0; // payload bytes the receiver has consumed since its last grant
+};
+constexpr size_t kCreditHeaderSize = 16;
+
+inline void encodeCreditHeader(const CreditHeader& h, uint8_t* out) noexcept {
+    out[0] = static_cast<uint8_t>(FrameKind::Credit);
+    out[1] = out[2] = out[3] = 0;
+    storeLE32(out + 4, h.session);
+    storeLE64(out + 8, h.bytes);
+}
+
+inline bool decodeCreditHeader(const void* data, size_t size, CreditHeader& out) noexcept {
+    const auto* p = static_cast<const uint8_t*>(data);
+    if (size != kCreditHeaderSize || p[0] != static_cast<uint8_t>(FrameKind::Credit)) return false;
+    out.session = loadLE32(p + 4);
+    out.bytes = loadLE64(p + 8);
+    return true;
+}
+
+// Control frame with no fields of its own (Hello, HelloAck, SubReady): [kind:1][reserved:3][session:4]
+constexpr size_t kControlHeaderSize = 8;
+
+inline void encodeControlHeader(FrameKind kind, uint32_t session, uint8_t* out) noexcept {
+    out[0] = static_cast<uint8_t>(kind);
+    out[1] = out[2] = out[3] = 0;
+    storeLE32(out + 4, session);
+}
+
+inline bool decodeControlHeader(const void* data, size_t size, FrameKind& kind, uint32_t& session) noexcept {
+    if (size != kControlHeaderSize) return false;
+    const auto* p = static_cast<const uint8_t*>(data);
+    kind = static_cast<FrameKind>(p[0]);
+    session = loadLE32(p + 4);
+    return true;
+}
+
+} // namespace wire
+
+#endif // WIRE_FORMAT_H
@@ -0,0 +1,176 @@
+#include "AsyncCommunicator.h"
+#include "Communicator.h"
+#include "CpuAffinity.h"
+#include <fcntl.h>
+#include <stdexcept>
+#include <unistd.h>
+
+AsyncCommunicator::AsyncCommunicator(int id, int port_base, std::string address, int num_parties, bool withPubSub)
+    : id_(id), port_base_(port_base), address_(std::move(address)), num_parties_(num_parties), withPubSub_(withPubSub) {
+    if (pipe(wakeFds_) != 0) {
+        throw std::runtime_error("AsyncCommunicator: pipe() failed");
+    }
+    // Non-blocking on both ends: the loop drains until empty, submitters never block on a full pipe
+    for (int fd : wakeFds_) fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+
+    std::promise<void> ready;
+    auto readyFuture = ready.get_future();
+    loop_ = std::thread([this, p = std::move(ready)]() mutable { runLoop(std::move(p)); });
+    try {
+        readyFuture.get();
+    } catch (...) {
+        if (loop_.joinable()) loop_.join();
+        close(wakeFds_[0]);
+        close(wakeFds_[1]);
+        throw;
+    }
+}
+
+AsyncCommunicator::~AsyncCommunicator() {
+    Command stop;
+    stop.op = Op::Stop;
+    submit(std::move(stop));
+    if (loop_.joinable()) loop_.join();
+    close(wakeFds_[0]);
+    close(wakeFds_[1]);
+}
+
+bool AsyncCommunicator::pinLoopThread(int core) {
+    return cpu::pinThread(loop_, core);
+}
+
+std::future<bool> AsyncCommunicator::asyncSend(int peerId, const std::string& payload) {
+    return submitSend(Op::Send, peerId, comm_->copyMessage(payload.data(), payload.size()));
+}
+
+std::future<bool> AsyncCommunicator::asyncSend(int peerId, zmq::message_t&& payload) {
+    return submitSend(Op::Send, peerId, std::move(payload));
+}
+
+std::future<bool> AsyncCommunicator::asyncSendToAll(const std::string& payload) {
+    return submitSend(Op::SendToAll, 0, comm_->copyMessage(payload.data(), payload.size()));
+}
+
+std::future<bool> AsyncCommunicator::asyncPublish(const std::string& payload) {
+    return submitSend(Op::Publish, 0, comm_->copyMessage(payload.data(), payload.size()));
+}
+
+std::future<zmq::message_t> AsyncCommunicator::asyncRecvFrom(int peerId) {
+    return submitRecv(Op::RecvFrom, peerId);
+}
+
+std::future<zmq::message_t> AsyncCommunicator::asyncSubRecvFrom(int publisherId) {
+    return submitRecv(Op::SubRecvFrom, publisherId);
+}
+
+std::future<bool> AsyncCommunicator::submitSend(Op op, int peerId, zmq::message_t&& payload) {
+    Command cmd;
+    cmd.op = op;
+    cmd.peer = peerId;
+    cmd.payload = std::move(payload);
+    auto fut = cmd.sent.get_future();
+    submit(std::move(cmd));
+    return fut;
+}
+
+std::future<zmq::message_t> AsyncCommunicator::submitRecv(Op op, int peerId) {
+    Command cmd;
+    cmd.op = op;
+    cmd.peer = peerId;
+    auto fut = cmd.received.get_future();
+    submit(std::move(cmd));
+    return fut;
+}
+
+void AsyncCommunicator::submit(Command&& cmd) {
+    {
+        std::lock_guard<std::mutex> lk(queueMutex_);
+        queue_.push_back(std::move(cmd));
+    }
+    // Ring the doorbell; a full pipe already guarantees a pending wake-up
+    const char b = 1;
+    (void)!write(wakeFds_[1], &b, 1);
+}
+
+void AsyncCommunicator::runLoop(std::promise<void> ready) {
+    try {
+        comm_ = std::make_unique<Communicator>(id_, port_base_, address_, num_parties_);
+        comm_->setUpRouterDealer();
+        if (withPubSub_) {
+            comm_->setUpPublisher();
+            comm_->setUpSubscribers();
+        }
+    } catch (...) {
+        comm_.reset();
+        ready.set_exception(std::current_exception());
+        return;
+    }
+    ready.set_value();
+
+    std::deque<Command> batch;
+    zmq::message_t msg;
+    int from = -1;
+    while (!stopping_) {
+        const int mask = comm_->waitInbound(-1, wakeFds_[0]);
+
+        if (mask & Communicator::kFdReady) {
+            char buf[64];
+            while (read(wakeFds_[0], buf, sizeof(buf)) > 0) {}
+        }
+        {
+            std::lock_guard<std::mutex> lk(queueMutex_);
+            batch.swap(queue_);
+        }
+        for (auto& cmd : batch) execute(cmd);
+        batch.clear();
+
+        // Drain each ready socket without blocking (timeout 0)
+        if (mask & Communicator::kRouterReady) {
+            while (comm_->routerReceive(from, msg, 0)) deliver(routerInbox_[from], std::move(msg));
+        }
+        if (mask & Communicator::kSubReady) {
+            while (comm_->subReceive(from, msg, 0)) deliver(subInbox_[from], std::move(msg));
+        }
+    }
+
+    // Sockets must be closed on the thread that used them. Unclaimed receive promises are
+    // destroyed with the inboxes and report std::future_errc::broken_promise.
+    comm_.reset();
+}
+
+void AsyncCommunicator::execute(Command& cmd) {
+    switch (cmd.op) {
+    case Op::Send:
+        cmd.sent.set_value(comm_->dealerSendTo(cmd.peer, std::move(cmd.payload)));
+        break;
+    case Op::SendToAll:
+        cmd.sent.set_value(comm_->dealerSendToAll(std::move(cmd.payload)));
+        break;
+    case Op::Publish:
+        cmd.sent.set_value(comm_->pubBroadcast(std::move(cmd.payload)));
+        break;
+    case Op::RecvFrom:
+    case Op::SubRecvFrom: {
+        Inbox& inbox = (cmd.op == Op::RecvFrom) ? routerInbox_[cmd.peer] : subInbox_[cmd.peer];
+        if (!inbox.arrived.empty()) {
+            cmd.received.set_value(std::move(inbox.arrived.front()));
+            inbox.arrived.pop_front();
+        } else {
+            inbox.waiting.push_back(std::move(cmd.received));
+        }
+        break;
+    }
+    case Op::Stop:
+        stopping_ = true;
+        break;
+    }
+}
+
+void AsyncCommunicator::deliver(Inbox& inbox, zmq::message_t&& msg) {
+    if (!inbox.waiting.empty()) {
+        inbox.waiting.front().set_value(std::move(msg));
+        inbox.waiting.pop_front();
+    } else {
+        inbox.arrived.push_back(std::move(msg));
+    }
+}
@@ -0,0 +1,226 @@
+#include "BufferPool.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace {
+
+// In front of every block, keeping the block itself 16-byte aligned
+struct BlockHeader {
+    BufferPool::Core* core; // null for oversize blocks, which bypass the pool
+    uint32_t cls;
+    uint32_t reserved;
+};
+static_assert(sizeof(BlockHeader) == 16, "block header must keep 16-byte alignment");
+
+constexpr unsigned kBatch = 16;           // blocks moved between a thread cache and the shared lists at once
+constexpr unsigned kCacheMax = 32;        // blocks cached per class per thread
+constexpr size_t kCacheBytes = 1 << 20;   // ... and at most this many bytes' worth of them
+constexpr unsigned kSlots = 4;            // pools a thread caches for at the same time
+
+unsigned cacheLimit(unsigned cls) noexcept {
+    const size_t n = kCacheBytes / BufferPool::classBytes(cls);
+    return n < 2 ? 2u : n > kCacheMax ? kCacheMax : static_cast<unsigned>(n);
+}
+
+BlockHeader* headerOf(void* block) noexcept { return static_cast<BlockHeader*>(block) - 1; }
+
+} // namespace
+
+struct BufferPool::Core {
+    std::mutex m;
+    std::vector<void*> shared[kClasses]; // blocks owned by the pool itself (they hold no reference)
+    std::atomic<bool> closed{false};
+    // One for the pool object plus one per block outside the shared lists (in use or in a thread
+    // cache); the last one out deletes the core
+    std::atomic<uint64_t> refs{1};
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> fresh{0};
+
+    void drop(uint64_t n) noexcept {
+        if (refs.fetch_sub(n, std::memory_order_acq_rel) == n) delete this;
+    }
+
+    // Move up to max shared blocks of cls into out; they now hold a reference each
+    unsigned refill(unsigned cls, void** out, unsigned max) {
+        std::lock_guard<std::mutex> lk(m);
+        auto& list = shared[cls];
+        const unsigned take = list.size() < max ? static_cast<unsigned>(list.size()) : max;
+        if (take == 0) return 0;
+        std::memcpy(out, list.data() + list.size() - take, take * sizeof(void*));
+        list.resize(list.size() - take);
+        refs.fetch_add(take, std::memory_order_relaxed);
+        return take;
+    }
+
+    // Give n blocks back: onto the shared list, or to the heap once the pool is gone
+    void spill(unsigned cls, void* const* blocks, unsigned n) noexcept {
+        {
+            std::lock_guard<std::mutex> lk(m);
+            bool kept = false;
+            if (!closed.load(std::memory_order_relaxed)) {
+                try {
+                    shared[cls].insert(shared[cls].end(), blocks, blocks + n);
+                    kept = true;
+                } catch (...) {
+                }
+            }
+            if (!kept) {
+                for (unsigned k = 0; k < n; ++k) std::free(headerOf(blocks[k]));
+            }
+        }
+        drop(n);
+    }
+};
+
+namespace {
+
+struct ThreadCache {
+    struct Slot {
+        BufferPool::Core* core = nullptr;
+        unsigned total = 0;
+        unsigned count[BufferPool::kClasses] = {};
+        void* blocks[BufferPool::kClasses][kCacheMax];
+
+        void flush() noexcept {
+            BufferPool::Core* c = core;
+            for (unsigned cls = 0; cls < BufferPool::kClasses && total > 0; ++cls) {
+                if (count[cls] == 0) continue;
+                const unsigned n = count[cls];
+                total -= n;
+                count[cls] = 0;
+                c->spill(cls, blocks[cls], n); // may delete the core once total reaches 0
+            }
+        }
+    };
+    Slot slots[kSlots];
+
+    ~ThreadCache();
+
+    // The slot caching for core, claiming an empty one if needed; null if all are busy. Slots
+    // still holding blocks of a destroyed pool are flushed first: long-lived threads (ZeroMQ's
+    // I/O threads above all) may never exit, and would otherwise keep those blocks and the slot.
+    Slot* find(BufferPool::Core* core) noexcept {
+        Slot* empty = nullptr;
+        for (Slot& s : slots) {
+            // The cached blocks hold references, so the core is still there to ask
+            if (s.total > 0 && s.core->closed.load(std::memory_order_relaxed)) s.flush();
+            // An empty slot may still name a core that has since been deleted; it holds nothing,
+            // so reusing it for whatever core now lives at that address is harmless
+            if (s.core == core) return &s;
+            if (!empty && s.total == 0) empty = &s;
+        }
+        if (empty) empty->core = core;
+        return empty;
+    }
+};
+
+// Trivially destructible, so it can still be read while other thread_locals are torn down
+thread_local bool tCacheGone = false;
+
+ThreadCache::~ThreadCache() {
+    tCacheGone = true;
+    for (Slot& s : slots) s.flush();
+}
+
+ThreadCache::Slot* cacheSlot(BufferPool::Core* core) noexcept {
+    if (tCacheGone) return nullptr;
+    thread_local ThreadCache cache;
+    return cache.find(core);
+}
+
+} // namespace
+
+BufferPool::BufferPool() : core_(new Core()) {}
+
+BufferPool::~BufferPool() {
+    core_->closed.store(true, std::memory_order_relaxed);
+    // Other threads' caches drain the next time they use any pool, or when they exit
+    if (ThreadCache::Slot* s = cacheSlot(core_)) s->flush();
+    {
+        std::lock_guard<std::mutex> lk(core_->m);
+        for (auto& list : core_->shared) {
+            for (void* block : list) std::free(headerOf(block));
+            list.clear();
+        }
+    }
+    core_->drop(1);
+}
+
+unsigned BufferPool::classOf(size_t bytes) noexcept {
+    if (bytes <= (size_t(1) << kMinShift)) return 0;
+    const unsigned shift = 64 - static_cast<unsigned>(__builtin_clzll(static_cast<unsigned long long>(bytes - 1)));
+    return shift > kMaxShift ? kClasses : shift - kMinShift;
+}
+
+void* BufferPool::allocate(size_t bytes) {
+    core_->allocations.fetch_add(1, std::memory_order_relaxed);
+    const unsigned cls = classOf(bytes);
+    if (cls < kClasses) {
+        if (ThreadCache::Slot* s = cacheSlot(core_)) {
+            if (s->count[cls] == 0) {
+                const unsigned got = core_->refill(cls, s->blocks[cls], kBatch < cacheLimit(cls) ? kBatch : cacheLimit(cls));
+                s->count[cls] = got;
+                s->total += got;
+            }
+            if (s->count[cls] > 0) {
+                --s->total;
+                return s->blocks[cls][--s->count[cls]];
+            }
+        } else {
+            void* block = nullptr;
+            if (core_->refill(cls, &block, 1) == 1) return block;
+        }
+    }
+
+    const size_t body = cls < kClasses ? classBytes(cls) : bytes;
+    if (body > SIZE_MAX - sizeof(BlockHeader)) throw std::bad_alloc();
+    auto* h = static_cast<BlockHeader*>(std::malloc(sizeof(BlockHeader) + body));
+    if (!h) throw std::bad_alloc();
+    h->core = cls < kClasses ? core_ : nullptr;
+    h->cls = cls;
+    h->reserved = 0;
+    if (h->core) core_->refs.fetch_add(1, std::memory_order_relaxed);
+    core_->fresh.fetch_add(1, std::memory_order_relaxed);
+    return h + 1;
+}
+
+void BufferPool::release(void* block) noexcept {
+    if (!block) return;
+    BlockHeader* h = headerOf(block);
+    Core* core = h->core;
+    if (!core) {
+        std::free(h);
+        return;
+    }
+    const unsigned cls = h->cls;
+    if (!core->closed.load(std::memory_order_relaxed)) {
+        if (ThreadCache::Slot* s = cacheSlot(core)) {
+            unsigned& count = s->count[cls];
+            if (count == cacheLimit(cls)) {
+                // Full: hand the older half back in one batch, e.g. to the thread that sends
+                const unsigned half = count / 2;
+                core->spill(cls, s->blocks[cls], half);
+                std::memmove(s->blocks[cls], s->blocks[cls] + half, (count - half) * sizeof(void*));
+                count -= half;
+                s->total -= half;
+            }
+            s->blocks[cls][count++] = block;
+            ++s->total;
+            return;
+        }
+    }
+    core->spill(cls, &block, 1);
+}
+
+BufferPool::Stats BufferPool::stats() const noexcept {
+    Stats s;
+    s.allocations = core_->allocations.load(std::memory_order_relaxed);
+    s.fresh = core_->fresh.load(std::memory_order_relaxed);
+    s.outstanding = core_->refs.load(std::memory_order_relaxed) - 1;
+    return s;
+}
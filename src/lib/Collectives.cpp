@@ -0,0 +1,120 @@
+#include "Collectives.h"
+#include "Communicator.h"
+#include "FieldPacking.h"
+#include "WireFormat.h"
+#include <algorithm>
+#include <cstdint>
+#include <stdexcept>
+
+Collectives::Collectives(Communicator& comm, uint64_t modulus, uint32_t firstRound)
+    : comm_(comm), modulus_(modulus), bits_(fieldpack::bitsFor(modulus)), nextRound_(firstRound),
+      id_(comm.getId()), n_(comm.getNumParties()) {
+    if (modulus < 2) throw std::invalid_argument("Collectives: modulus must be at least 2");
+    if (n_ <= 0 || id_ < 1 || id_ > n_) throw std::invalid_argument("Collectives: communicator needs a party count");
+}
+
+bool Collectives::sendValues(int peerId, uint32_t round, const uint64_t* values, size_t count) {
+    // [count: u64 LE][count x bits_ bits]
+    zmq::message_t msg = comm_.allocMessage(sizeof(uint64_t) + fieldpack::packedSize(count, bits_));
+    auto* p = static_cast<uint8_t*>(msg.data());
+    wire::storeLE64(p, count);
+    fieldpack::pack(values, count, bits_, p + sizeof(uint64_t));
+    return comm_.dealerSendRound(peerId, round, std::move(msg));
+}
+
+bool Collectives::recvValues(int peerId, uint32_t round, size_t expected, int timeoutMs) {
+    zmq::message_t msg;
+    if (!comm_.routerReceiveRound(peerId, round, msg, timeoutMs)) return false;
+    if (msg.size() < sizeof(uint64_t)) return false;
+    const auto* p = static_cast<const uint8_t*>(msg.data());
+    const uint64_t count = wire::loadLE64(p);
+    if (expected != SIZE_MAX && count != expected) return false;
+    if (count > (msg.size() - sizeof(uint64_t)) * 8 / bits_) return false;
+    if (msg.size() != sizeof(uint64_t) + fieldpack::packedSize(count, bits_)) return false;
+    scratch_.resize(count);
+    fieldpack::unpack(p + sizeof(uint64_t), scratch_.size(), bits_, scratch_.data());
+    return true;
+}
+
+void Collectives::addInto(uint64_t* acc, const uint64_t* values, size_t count) const noexcept {
+    // Operands are below modulus_, which may exceed 2^63, so never form acc + value directly
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t room = modulus_ - acc[i];
+        acc[i] = values[i] >= room ? values[i] - room : acc[i] + values[i];
+    }
+}
+
+bool Collectives::broadcast(std::vector<uint64_t>& data, int root, int timeoutMs) {
+    if (root < 1 || root > n_) return false;
+    const uint32_t round = nextRound_++;
+    // Work in ranks relative to the root: rank r receives from r - lowbit(r), then forwards to
+    // r + m for every power of two m below lowbit(r)
+    const int rel = (id_ - root + n_) % n_;
+    auto partyOf = [&](int r) { return (r + root - 1) % n_ + 1; };
+
+    int mask = 1;
+    while (mask < n_) {
+        if (rel & mask) {
+            if (!recvValues(partyOf(rel - mask), round, SIZE_MAX, timeoutMs)) return false;
+            data.swap(scratch_);
+            break;
+        }
+        mask <<= 1;
+    }
+    bool ok = true;
+    for (mask >>= 1; mask > 0; mask >>= 1) {
+        if (rel + mask < n_ && !sendValues(partyOf(rel + mask), round, data.data(), data.size())) ok = false;
+    }
+    return ok;
+}
+
+bool Collectives::reduce(std::vector<uint64_t>& data, int root, int timeoutMs) {
+    if (root < 1 || root > n_) return false;
+    const uint32_t round = nextRound_++;
+    // Mirror image of broadcast: fold in children r + m for growing m, then send to the parent
+    const int rel = (id_ - root + n_) % n_;
+    auto partyOf = [&](int r) { return (r + root - 1) % n_ + 1; };
+
+    for (int mask = 1; mask < n_; mask <<= 1) {
+        if (rel & mask) {
+            return sendValues(partyOf(rel - mask), round, data.data(), data.size());
+        }
+        if (rel + mask < n_) {
+            if (!recvValues(partyOf(rel + mask), round, data.size(), timeoutMs)) return false;
+            addInto(data.data(), scratch_.data(), data.size());
+        }
+    }
+    return true;
+}
+
+bool Collectives::allreduce(std::vector<uint64_t>& data, int timeoutMs) {
+    if (n_ == 1) return true;
+    const uint32_t round = nextRound_++;
+    const int rank = id_ - 1;
+    const int right = (rank + 1) % n_ + 1;
+    const int left = (rank + n_ - 1) % n_ + 1;
+    const size_t len = data.size();
+    // Segment k covers [begin(k), begin(k + 1))
+    auto begin = [&](int k) { return len * static_cast<size_t>(k) / static_cast<size_t>(n_); };
+    auto segLen = [&](int k) { return begin(k + 1) - begin(k); };
+    auto seg = [&](int k) { return ((k % n_) + n_) % n_; };
+
+    // Reduce-scatter: after step s, segment rank - s - 1 holds the sum over s + 2 parties.
+    // Sends never block (DEALER, no HWM), so send-then-receive cannot deadlock around the ring.
+    for (int s = 0; s < n_ - 1; ++s) {
+        const int out = seg(rank - s);
+        const int in = seg(rank - s - 1);
+        if (!sendValues(right, round, data.data() + begin(out), segLen(out))) return false;
+        if (!recvValues(left, round, segLen(in), timeoutMs)) return false;
+        addInto(data.data() + begin(in), scratch_.data(), segLen(in));
+    }
+    // Allgather: this party now owns the full sum of segment rank + 1; pass sums around the ring
+    for (int s = 0; s < n_ - 1; ++s) {
+        const int out = seg(rank + 1 - s);
+        const int in = seg(rank - s);
+        if (!sendValues(right, round, data.data() + begin(out), segLen(out))) return false;
+        if (!recvValues(left, round, segLen(in), timeoutMs)) return false;
+        std::copy(scratch_.begin(), scratch_.end(), data.begin() + static_cast<std::ptrdiff_t>(begin(in)));
+    }
+    return true;
+}
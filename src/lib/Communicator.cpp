@@ -2,37 +2,229 @@
 #include <vector>
 #include <numeric>
 #include "Communicator.h"
+#include "PeerSendPool.h"
+#include "WireFormat.h"
+#include "MessageCursor.h"
+#include "FieldPacking.h"
+#include "Trace.h"
+#include "CpuAffinity.h"
+#include <cstring>
 #include <iostream>
+#include <chrono>
+#include <algorithm>
+#include <cerrno>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <ifaddrs.h>
+#include <netdb.h>
+#include <unistd.h>
+#include <sys/socket.h>
 
+namespace {
+// Party ids travel as decimal routing ids / topics ("7"). Parse them straight from the
+// frame bytes so the hot receive path does not build a std::string.
+int parsePartyId(const zmq::message_t& frame) noexcept {
+    const char* p = static_cast<const char*>(frame.data());
+    const size_t n = frame.size();
+    if (n == 0 || n > 9) return -1;
+    int value = 0;
+    for (size_t i = 0; i < n; ++i) {
+        if (p[i] < '0' || p[i] > '9') return -1;
+        value = value * 10 + (p[i] - '0');
+    }
+    return value;
+}
 
+// True if std::to_string(id) reproduces the routing id frame, so it needs no copy of its own
+bool isCanonicalPartyId(const zmq::message_t& frame, int id) noexcept {
+    return id >= 0 && (id == 0 ? frame.size() == 1 : static_cast<const char*>(frame.data())[0] != '0');
+}
 
-// Send the payload to all peer ROUTERs in parallel (one thread per peer, each with its own DEALER socket)
-bool Communicator::dealerSendToAllParallel(const std::string& payload) {
-    // Ensure results vector is sized (lazy safeguard in case constructor variant without num_parties was used)
-    if (workerResults_.size() < static_cast<size_t>(num_parties)) {
-        workerResults_.assign(static_cast<size_t>(num_parties), 0);
-    }
+std::string tcpEndpoint(const std::string& address, int port) {
+    return "tcp://" + address + ":" + std::to_string(port);
+}
+// Per-user path, so runs by different users on a shared host neither collide nor trip over each
+// other's leftover socket files
+std::string ipcEndpoint(int port) {
+    return "ipc:///tmp/sc-" + std::to_string(getuid()) + "-" + std::to_string(port) + ".ipc";
+}
+std::string inprocEndpoint(int port) {
+    return "inproc://sc-" + std::to_string(port);
+}
 
-    for (size_t i = 0; i < num_parties; ++i) {
-        const int peerId = this->ids[i];
-        if (peerId == this->id) continue; // skip self
-        // Reset slot before starting worker
-        workerResults_[i] = 0;
-        workerThreads_.emplace_back([this, &payload, i, peerId]() {
-            // Use pre-initialized per-peer DEALER sockets; no connect here.
-            workerResults_[i] = this->dealerSendTo(peerId, payload) ? 1 : 0;
-        });
+// In-process bind registry for Transport::Auto: (address, port) -> context the socket lives on.
+// inproc only works between sockets of one context, so the context is part of the match.
+std::mutex& registryMutex() {
+    static std::mutex m;
+    return m;
+}
+std::map<std::pair<std::string, int>, const zmq::context_t*>& registry() {
+    static std::map<std::pair<std::string, int>, const zmq::context_t*> r;
+    return r;
+}
+
+// True if address names this host: loopback, or the numeric form of a local interface address
+bool isLocalAddress(const std::string& address) {
+    if (address == "localhost" || address == "::1" || address.rfind("127.", 0) == 0) return true;
+    static std::mutex m;
+    static std::set<std::string> local;
+    static bool loaded = false;
+    std::lock_guard<std::mutex> lk(m);
+    if (!loaded) {
+        loaded = true;
+        ifaddrs* ifs = nullptr;
+        if (getifaddrs(&ifs) == 0) {
+            for (ifaddrs* it = ifs; it; it = it->ifa_next) {
+                if (!it->ifa_addr) continue;
+                const int family = it->ifa_addr->sa_family;
+                if (family != AF_INET && family != AF_INET6) continue;
+                char host[NI_MAXHOST];
+                const socklen_t len = family == AF_INET ? sizeof(sockaddr_in) : sizeof(sockaddr_in6);
+                if (getnameinfo(it->ifa_addr, len, host, sizeof(host), nullptr, 0, NI_NUMERICHOST) == 0) {
+                    local.insert(host);
+                }
+            }
+            freeifaddrs(ifs);
+        }
     }
+    return local.count(address) != 0;
+}
+} // namespace
+
+// Stamps the start of a receive call for the per-peer receive-wait histograms
+struct Communicator::ReceiveTimer {
+    Communicator& owner;
+    const Clock::time_point outer; // restored on exit, for receives called from receives
+    explicit ReceiveTimer(Communicator& c) noexcept : owner(c), outer(c.recvStart_) { owner.recvStart_ = owner.metricsNow(); }
+    ~ReceiveTimer() { owner.recvStart_ = outer; }
+};
 
-    for (auto& t : workerThreads_) if (t.joinable()) t.join();
-    workerThreads_.clear();
+std::shared_ptr<zmq::context_t> Communicator::processContext() {
+    // Several parties' TCP/IPC traffic can share it, so give it more than one I/O thread.
+    // inproc traffic does not use I/O threads at all.
+    static std::shared_ptr<zmq::context_t> ctx = std::make_shared<zmq::context_t>(
+        static_cast<int>(std::max(1u, std::thread::hardware_concurrency() / 2)));
+    return ctx;
+}
+
+void Communicator::ensureContext() {
+    if (context_) return;
+    if (transport_ == Transport::Inproc || transport_ == Transport::Auto) {
+        context_ = processContext();
+    } else {
+        context_ = std::make_shared<zmq::context_t>(1);
+    }
+}
 
-    // Return true only if all non-self sends succeeded
-    for (size_t i = 0; i < ids.size(); ++i) {
-        if (ids[i] == this->id) continue;
-        if (workerResults_[i] == 0) return false;
+bool Communicator::setIoThreadCores(const std::vector<int>& cores) {
+#ifdef ZMQ_THREAD_AFFINITY_CPU_ADD
+    if (cores.empty()) return false;
+    ensureContext();
+    for (int core : cores) {
+        if (zmq_ctx_set(context_->handle(), ZMQ_THREAD_AFFINITY_CPU_ADD, core) != 0) return false;
     }
     return true;
+#else
+    (void)cores;
+    return false;
+#endif
+}
+
+void Communicator::bindEndpoints(zmq::socket_t& sock, int port) {
+    switch (transport_) {
+    case Transport::Tcp:
+        sock.bind(tcpEndpoint(address, port));
+        break;
+    case Transport::Ipc:
+        sock.bind(ipcEndpoint(port));
+        break;
+    case Transport::Inproc:
+        sock.bind(inprocEndpoint(port));
+        break;
+    case Transport::Auto:
+        sock.bind(tcpEndpoint(address, port));
+        if (isLocalAddress(address)) sock.bind(ipcEndpoint(port));
+        sock.bind(inprocEndpoint(port));
+        {
+            std::lock_guard<std::mutex> lk(registryMutex());
+            registry()[{address, port}] = context_.get();
+        }
+        boundPorts_.push_back(port);
+        break;
+    }
+}
+
+std::string Communicator::connectEndpoint(int port) const {
+    switch (transport_) {
+    case Transport::Tcp:
+        return tcpEndpoint(address, port);
+    case Transport::Ipc:
+        return ipcEndpoint(port);
+    case Transport::Inproc:
+        return inprocEndpoint(port);
+    case Transport::Auto:
+        break;
+    }
+    {
+        std::lock_guard<std::mutex> lk(registryMutex());
+        auto it = registry().find({address, port});
+        if (it != registry().end()) {
+            if (it->second == context_.get()) return inprocEndpoint(port);
+            // An Auto bind on a local address serves ipc as well
+            if (isLocalAddress(address)) return ipcEndpoint(port);
+        }
+    }
+    // Any other peer may have bound tcp only (Transport::Tcp, or another process), which every
+    // mode but Ipc and Inproc serves
+    return tcpEndpoint(address, port);
+}
+
+std::string Communicator::dealerEndpoint(int peerId) const {
+    auto it = dealerEndpoints_.find(peerId);
+    return it == dealerEndpoints_.end() ? std::string() : it->second;
+}
+
+// Send the payload to all peer ROUTERs in parallel using the persistent per-peer sender lanes
+bool Communicator::dealerSendToAllParallel(const std::string& payload) {
+    return dealerSendToAllParallel(copyMessage(payload.data(), payload.size()));
+}
+
+bool Communicator::dealerSendToAllParallel(zmq::message_t&& payload) {
+    // One shared ROUTER cannot be driven from several lanes
+    if (mesh_) return dealerSendToAll(std::move(payload));
+    if (!sendPool_) {
+        std::vector<int> peers;
+        peers.reserve(ids.size());
+        for (int peerId : ids) {
+            if (peerId == this->id) continue; // skip self
+            peers.push_back(peerId);
+        }
+        // Lanes use the pre-initialized per-peer DEALER sockets; no connect here.
+        sendPool_ = std::make_unique<PeerSendPool>(peers, [this](int peerId, zmq::message_t&& msg) {
+            const size_t bytes = msg.size();
+            const auto started = this->metricsNow();
+            const bool ok = this->rawDealerSend(peerId, std::move(msg));
+            if (!ok) this->refundCredit(peerId, bytes); // each lane touches only its own peer's entry
+            this->noteSent(peerId, bytes, ok, started);
+            return ok;
+        }, workerCores_);
+    }
+    // Credit is taken here, on the thread that owns the ROUTER, before the lanes run
+    if (flowBudget_ > 0) {
+        const auto deadline = deadlineAfter(creditTimeoutMs_);
+        for (int peerId : ids) {
+            if (peerId == this->id) continue;
+            if (!acquireCredit(peerId, payload.size(), deadline)) {
+                for (int undo : ids) {
+                    if (undo == peerId) break;
+                    if (undo != this->id) refundCredit(undo, payload.size());
+                }
+                return false;
+            }
+        }
+    }
+    return sendPool_->sendToAll(payload);
 }
 
 Communicator::Communicator(int id, int port_base, std::string address)
@@ -44,48 +236,38 @@ Communicator::Communicator(int id, int port_base, std::string address, int num_p
         for (int i = 1; i <= num_parties; ++i) {
             ids.push_back(i);
         }
-    // Pre-size reusable worker structures once
-    workerResults_.assign(static_cast<size_t>(num_parties), 0);
-    workerThreads_.reserve(num_parties);
+        metricsSlots_ = static_cast<size_t>(std::max(0, num_parties)) + 1;
+        metrics_.reset(new PeerCounters[metricsSlots_]);
     }
 
 Communicator::~Communicator() {
-    joinAndClearWorkers();
-}
-
-void Communicator::joinAndClearWorkers() noexcept {
-    for (auto& t : workerThreads_) {
-        if (t.joinable()) {
-            try { t.join(); } catch (...) { /* swallow */ }
-        }
+    // Join sender lanes before any socket they use is closed
+    sendPool_.reset();
+    if (!boundPorts_.empty()) {
+        std::lock_guard<std::mutex> lk(registryMutex());
+        for (int port : boundPorts_) registry().erase({address, port});
     }
-    workerThreads_.clear();
 }
 
 
 void Communicator::setUpRouter() {
-    if (!context_) {
-        context_ = std::make_unique<zmq::context_t>(1);
-    }
+    ensureContext();
     if (!router_) {
         router_ = std::make_unique<zmq::socket_t>(*context_, zmq::socket_type::router);
-        std::string bind_address = "tcp://" + address + ":" + std::to_string(port_base + id);
-        router_->bind(bind_address);
+        bindEndpoints(*router_, port_base + id);
         router_->set(zmq::sockopt::rcvhwm, 0); // no limit
         router_->set(zmq::sockopt::rcvtimeo, -1); // block indefinitely
-        // std::cout << "Router " << id << " running at " << bind_address << std::endl;
+        pollSetDirty_ = true;
     }
 }
 
 void Communicator::setUpPerPeerDealers() {
-    if (!context_) {
-        context_ = std::make_unique<zmq::context_t>(1);
-    }
+    ensureContext();
     for (int party_id : this->ids) {
         if (party_id == this->id) continue; // skip self
         auto& sockPtr = perPeerDealer_[party_id];
         if (sockPtr) continue; // already prepared
-        const std::string addr = "tcp://" + address + ":" + std::to_string(port_base + party_id);
+        const std::string addr = connectEndpoint(port_base + party_id);
         sockPtr = std::make_unique<zmq::socket_t>(*context_, zmq::socket_type::dealer);
         const std::string plainId = std::to_string(this->id);
         sockPtr->set(zmq::sockopt::routing_id, plainId);
@@ -93,6 +275,8 @@ void Communicator::setUpPerPeerDealers() {
         sockPtr->set(zmq::sockopt::sndtimeo, 1000);
         sockPtr->set(zmq::sockopt::sndhwm, 0); // no limit
         sockPtr->connect(addr);
+        dealerEndpoints_[party_id] = addr;
+        pollSetDirty_ = true;
         // std::cout << "Dealer " << this->id << " (per-peer) connected to " << addr << std::endl;
     }
 }
@@ -102,79 +286,869 @@ void Communicator::setUpRouterDealer() {
     this->setUpPerPeerDealers();
 }
 
-void Communicator::setUpPublisher() {
-    if (!context_) {
-        context_ = std::make_unique<zmq::context_t>(1);
+void Communicator::setUpMesh() {
+    ensureContext();
+    if (router_) return;
+    router_ = std::make_unique<zmq::socket_t>(*context_, zmq::socket_type::router);
+    router_->set(zmq::sockopt::routing_id, std::to_string(id)); // how peers we connect to see us
+    router_->set(zmq::sockopt::router_mandatory, 1);           // unreachable peer -> EHOSTUNREACH, not a silent drop
+    router_->set(zmq::sockopt::rcvhwm, 0);
+    router_->set(zmq::sockopt::sndhwm, 0);
+    bindEndpoints(*router_, port_base + id);
+    meshIds_.assign(ids.size() + 1, std::string());
+    for (int party_id : ids) {
+        meshIds_[party_id] = std::to_string(party_id);
+        if (party_id >= id) continue;
+        // Name the outgoing pipe so we can address the peer before it has said anything
+        router_->set(zmq::sockopt::connect_routing_id, meshIds_[party_id]);
+        router_->connect(connectEndpoint(port_base + party_id));
+    }
+    mesh_ = true;
+    pollSetDirty_ = true;
+}
+
+bool Communicator::meshSend(int peerId, zmq::message_t* header, zmq::message_t&& payload, Clock::time_point deadline) {
+    if (peerId == this->id || peerId <= 0 || static_cast<size_t>(peerId) >= meshIds_.size()) return false;
+    const std::string& rid = meshIds_[peerId];
+    zmq::message_t idFrame(rid.data(), rid.size());
+    while (true) {
+        try {
+            // router_mandatory fails the identity frame, so nothing partial is ever queued
+            if (!router_->send(idFrame, zmq::send_flags::sndmore | zmq::send_flags::dontwait)) return false;
+            break;
+        } catch (const zmq::error_t& e) {
+            if (e.num() != EHOSTUNREACH || Clock::now() >= deadline) return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1)); // peer still connecting
+    }
+    if (header && !router_->send(*header, zmq::send_flags::sndmore)) return false;
+    return router_->send(std::move(payload), zmq::send_flags::none).has_value();
+}
+
+bool Communicator::sendControl(int peerId, uint8_t kind, bool once) {
+    zmq::message_t header(wire::kControlHeaderSize);
+    wire::encodeControlHeader(static_cast<wire::FrameKind>(kind), session_, static_cast<uint8_t*>(header.data()));
+    if (mesh_) {
+        return meshSend(peerId, &header, zmq::message_t(), once ? Clock::time_point::min() : deadlineAfter(creditTimeoutMs_));
+    }
+    return rawSendTagged(peerId, header, zmq::message_t());
+}
+
+void Communicator::publishBeacon() {
+    const std::string topicStr = std::to_string(id);
+    zmq::message_t topic(topicStr.data(), topicStr.size());
+    zmq::message_t header(wire::kControlHeaderSize);
+    wire::encodeControlHeader(wire::FrameKind::Hello, session_, static_cast<uint8_t*>(header.data()));
+    if (!pub_->send(topic, zmq::send_flags::sndmore | zmq::send_flags::dontwait)) return;
+    if (!pub_->send(header, zmq::send_flags::sndmore | zmq::send_flags::dontwait)) return;
+    pub_->send(zmq::message_t(), zmq::send_flags::dontwait);
+}
+
+void Communicator::handleBeacon(int fromId, const zmq::message_t& header) {
+    wire::FrameKind kind;
+    uint32_t session = 0;
+    if (!wire::decodeControlHeader(header.data(), header.size(), kind, session)) return;
+    if (kind != wire::FrameKind::Hello || session != session_ || !knownPeer(fromId)) return;
+    if (meshState_.size() != ids.size() + 1) meshState_.assign(ids.size() + 1, 0);
+    if (meshState_[fromId] & kBeaconFrom) return;
+    // Tell the publisher its PUB reaches us; it keeps beaconing until every peer has said so
+    if (sendControl(fromId, static_cast<uint8_t>(wire::FrameKind::SubReady), false)) meshState_[fromId] |= kBeaconFrom;
+}
+
+bool Communicator::awaitMeshReady(Clock::time_point deadline) {
+    if (!router_ || ids.empty()) return false;
+    if (meshState_.size() != ids.size() + 1) meshState_.assign(ids.size() + 1, 0);
+    const bool withPubSub = pub_ && sub_;
+    const uint8_t need = kHelloFrom | kAckFrom | (withPubSub ? kBeaconFrom | kSubReadyFrom : 0);
+    // Beacons repeat because PUB drops everything until a subscription has propagated;
+    // in mesh mode a Hello to a not-yet-connected peer is retried on the same beat
+    const auto beat = std::chrono::milliseconds(5);
+    auto nextBeacon = Clock::time_point::min();
+    zmq::message_t topic;
+    zmq::message_t payload;
+    while (true) {
+        bool ready = true;
+        for (int peer : ids) {
+            if (peer == id) continue;
+            uint8_t& st = meshState_[peer];
+            if (!(st & kHelloSent) && sendControl(peer, static_cast<uint8_t>(wire::FrameKind::Hello), true)) st |= kHelloSent;
+            if ((st & need) != need) ready = false;
+        }
+        if (ready) return true;
+
+        const auto now = Clock::now();
+        if (now >= deadline) return false;
+        if (withPubSub && now >= nextBeacon) {
+            publishBeacon();
+            nextBeacon = now + beat;
+        }
+        const auto wakeAt = std::min(deadline, now + beat);
+        // Sockets only: application messages parked below must not turn this wait into a spin
+        waitInbound(static_cast<int>(std::chrono::duration_cast<std::chrono::milliseconds>(wakeAt - now).count()), -1, false);
+        while (pumpRouter(Clock::time_point::min()) != Pumped::Nothing) {}
+        if (withPubSub) {
+            while (readSubFrames(topic, payload, zmq::recv_flags::dontwait)) {
+                pendingSub_.emplace_back(std::move(topic), std::move(payload));
+            }
+        }
     }
+}
+
+void Communicator::setUpPublisher() {
+    ensureContext();
     if (!pub_) {
         pub_ = std::make_unique<zmq::socket_t>(*context_, zmq::socket_type::pub);
-        std::string bind_address = "tcp://" + address + ":" + std::to_string(port_base + 1000 + id);
-        pub_->bind(bind_address);
+        bindEndpoints(*pub_, port_base + 1000 + id);
         pub_->set(zmq::sockopt::sndhwm, 0); // no limit
         // PUB is best-effort; leave sndtimeo default, we use dontwait on send
     }
 }
 
 void Communicator::setUpSubscribers() {
-    if (!context_) {
-        context_ = std::make_unique<zmq::context_t>(1);
-    }
+    ensureContext();
     if (!sub_) {
         sub_ = std::make_unique<zmq::socket_t>(*context_, zmq::socket_type::sub);
         // Subscribe to all topics
         sub_->set(zmq::sockopt::subscribe, "");
         sub_->set(zmq::sockopt::rcvhwm, 0);
         sub_->set(zmq::sockopt::rcvtimeo, -1);
+        pollSetDirty_ = true;
     }
     for (int party_id : this->ids) {
         if (party_id == this->id) continue;
-        std::string addr = "tcp://" + address + ":" + std::to_string(port_base + 1000 + party_id);
+        const std::string addr = connectEndpoint(port_base + 1000 + party_id);
         // ZeroMQ allows duplicate connects; we don't track to keep overhead minimal.
         sub_->connect(addr);
     }
 }
 
-// bool Communicator::dealerSendToAll(const std::string& payload) {
-//     if (!dealer_) return false;
-//     zmq::message_t msg(payload.begin(), payload.end());
-//     auto rc = dealer_->send(msg, zmq::send_flags::none);
-//     return rc.has_value();
-// }
+bool Communicator::dealerSendToAll(const std::string& payload) {
+    // Single copy into a zmq-owned buffer; every peer below gets a ref-counted share of it
+    return dealerSendToAll(copyMessage(payload.data(), payload.size()));
+}
 
-bool Communicator::routerReceive(std::string& fromIdentity, std::string& payload, int timeoutMs) {
-    if (!router_) return false;
-    // Use socket receive timeout instead of poll to keep it simple and robust
-    if (timeoutMs >= 0) router_->set(zmq::sockopt::rcvtimeo, timeoutMs);
-    // ROUTER sockets receive [identity][payload]
-    zmq::message_t identity;
-    zmq::message_t payloadMsg;
+bool Communicator::dealerSendToAll(zmq::message_t&& payload) {
+    bool allOk = true;
+    for (int peerId : this->ids) {
+        if (peerId == this->id) continue; // skip self
+        zmq::message_t share;
+        share.copy(payload); // zmq_msg_copy: bumps the refcount, no payload copy
+        if (!dealerSendTo(peerId, std::move(share))) allOk = false;
+    }
+    return allOk;
+}
 
-    // Some patterns insert an empty delimiter; handle both 2- or 3-part messages
-    if (!router_->recv(identity, zmq::recv_flags::none)) return false;
+bool Communicator::readRouterFrames(zmq::message_t& identity, zmq::message_t& header, zmq::message_t& payload, zmq::recv_flags flags) {
+    // ROUTER sockets receive [identity][payload]
+    if (!router_->recv(identity, flags)) return false;
 
-    // Peek if there is a second frame
-    zmq::message_t second;
-    auto secondRes = router_->recv(second, zmq::recv_flags::none);
+    // Remaining frames of a multipart message are already queued, so no flags needed.
+    auto secondRes = router_->recv(payload, zmq::recv_flags::none);
     if (!secondRes.has_value()) return false;
 
     // Common patterns:
     // 1) [id][payload]
-    // 2) [id][empty][payload]
-    int more = 0;
-    size_t more_size = sizeof(more);
-    router_->getsockopt(ZMQ_RCVMORE, &more, &more_size);
-
-    if (more && second.size() == 0) {
-        // Empty delimiter present; next frame is payload
-    auto payloadRes = router_->recv(payloadMsg, zmq::recv_flags::none);
-    if (!payloadRes.has_value()) return false;
-    } else {
-        // No delimiter; 'second' is payload
-        payloadMsg = std::move(second);
+    // 2) [id][empty][payload]   (REQ-style delimiter)
+    // 3) [id][header][payload]  (tagged message, see WireFormat.h)
+    // message_t::more() reads the frame flag directly; no getsockopt round trip.
+    if (payload.more()) {
+        if (payload.size() == 0) header.rebuild();
+        else header = std::move(payload);
+        auto payloadRes = router_->recv(payload, zmq::recv_flags::none);
+        if (!payloadRes.has_value()) return false;
+    } else if (header.size() != 0) {
+        header.rebuild();
     }
+    return true;
+}
+
+Communicator::Clock::time_point Communicator::deadlineAfter(int timeoutMs) {
+    if (timeoutMs < 0) return Clock::time_point::max();
+    return Clock::now() + std::chrono::milliseconds(timeoutMs);
+}
+
+bool Communicator::pollRouter(Clock::time_point deadline) {
+    zmq::pollitem_t item{router_->handle(), 0, ZMQ_POLLIN, 0};
+    long waitMs = -1;
+    if (deadline != Clock::time_point::max()) {
+        const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+        waitMs = left > 0 ? static_cast<long>(left) : 0;
+    }
+    return zmq::poll(&item, 1, waitMs) > 0 && (item.revents & ZMQ_POLLIN);
+}
+
+int Communicator::spinPoll(zmq::pollitem_t* items, size_t count, long waitMs) {
+    if (spinUs_ > 0 && waitMs != 0) {
+        const auto spinUntil = Clock::now() + std::chrono::microseconds(spinUs_);
+        do {
+            const int ready = zmq::poll(items, count, 0);
+            if (ready > 0) return ready;
+            cpu::relax();
+        } while (Clock::now() < spinUntil);
+    }
+    return zmq::poll(items, count, waitMs);
+}
+
+Communicator::Pumped Communicator::pumpRouter(Clock::time_point deadline) {
+    zmq::message_t payload;
+    // Busy-poll mode: retry the non-blocking read until spinUntil before sleeping in poll
+    Clock::time_point spinUntil = Clock::time_point::min();
+    while (true) {
+        // Fast path: a queued message is read without any poll or timeout bookkeeping
+        if (readRouterFrames(identityScratch_, headerScratch_, payload, zmq::recv_flags::dontwait)) {
+            const int fromId = parsePartyId(identityScratch_);
+            if (headerScratch_.size() == 0) {
+                noteArrived(fromId);
+                pendingRouter_.push_back({fromId, std::move(payload), std::string()});
+                if (!isCanonicalPartyId(identityScratch_, fromId)) {
+                    pendingRouter_.back().identity.assign(static_cast<const char*>(identityScratch_.data()), identityScratch_.size());
+                }
+                return Pumped::Untagged;
+            }
+            handleTaggedMessage(fromId, headerScratch_, std::move(payload));
+            return Pumped::Tagged;
+        }
+        const auto now = Clock::now();
+        if (now >= deadline) return Pumped::Nothing;
+        if (spinUs_ > 0) {
+            if (spinUntil == Clock::time_point::min()) spinUntil = now + std::chrono::microseconds(spinUs_);
+            if (now < spinUntil) {
+                cpu::relax();
+                continue;
+            }
+        }
+        pollRouter(deadline);
+    }
+}
+
+void Communicator::handleTaggedMessage(int fromId, const zmq::message_t& header, zmq::message_t&& payload) {
+    switch (static_cast<wire::FrameKind>(wire::headerKind(header.data(), header.size()))) {
+    case wire::FrameKind::Round: {
+        wire::RoundHeader h;
+        if (!wire::decodeRoundHeader(header.data(), header.size(), h)) return;
+        if (h.session != session_) { // stale traffic from another session
+            returnStaleCredit(fromId, h.session, payload.size());
+            return;
+        }
+        noteArrived(fromId);
+        reorder_[{fromId, h.round}].push_back(std::move(payload));
+        return;
+    }
+    case wire::FrameKind::Credit: {
+        wire::CreditHeader h;
+        if (!wire::decodeCreditHeader(header.data(), header.size(), h)) return;
+        if (h.session != session_ || fromId <= 0 || static_cast<size_t>(fromId) >= sendCredit_.size()) return;
+        sendCredit_[fromId] += static_cast<int64_t>(h.bytes);
+        return;
+    }
+    case wire::FrameKind::Hello:
+    case wire::FrameKind::HelloAck:
+    case wire::FrameKind::SubReady: {
+        wire::FrameKind kind;
+        uint32_t session = 0;
+        if (!wire::decodeControlHeader(header.data(), header.size(), kind, session)) return;
+        if (session != session_ || !knownPeer(fromId)) return;
+        if (meshState_.size() != ids.size() + 1) meshState_.assign(ids.size() + 1, 0);
+        if (kind == wire::FrameKind::Hello) {
+            // Answered from whatever receive call pumped it, so the prober never waits on us
+            if (sendControl(fromId, static_cast<uint8_t>(wire::FrameKind::HelloAck), false)) meshState_[fromId] |= kHelloFrom;
+        } else if (kind == wire::FrameKind::HelloAck) {
+            meshState_[fromId] |= kAckFrom;
+        } else {
+            meshState_[fromId] |= kSubReadyFrom;
+        }
+        return;
+    }
+    case wire::FrameKind::Chunk: {
+        wire::ChunkHeader h;
+        if (!wire::decodeChunkHeader(header.data(), header.size(), h)) return;
+        if (h.session != session_) {
+            returnStaleCredit(fromId, h.session, payload.size());
+            return;
+        }
+        StreamChunk chunk;
+        chunk.index = h.index;
+        chunk.count = h.count;
+        chunk.offset = h.offset;
+        chunk.total = h.total;
+        chunk.data = std::move(payload);
+        noteArrived(fromId);
+        streams_[{fromId, h.stream}].push_back(std::move(chunk));
+        return;
+    }
+    default:
+        return; // unknown header kind: drop
+    }
+}
+
+bool Communicator::routerReceive(std::string& fromIdentity, std::string& payload, int timeoutMs) {
+    if (!router_) return false;
+    const ReceiveTimer timer(*this);
+    SC_TRACE_SCOPE(trace, Recv, id, -1, 0);
+    if (pendingRouter_.empty()) {
+        const auto deadline = deadlineAfter(timeoutMs);
+        while (pendingRouter_.empty()) {
+            if (pumpRouter(deadline) == Pumped::Nothing) return false;
+        }
+    }
+    auto& front = pendingRouter_.front();
+    SC_TRACE_SET(trace, front.from, front.payload.size());
+    fromIdentity = front.identity.empty() ? std::to_string(front.from) : front.identity;
+    payload.assign(static_cast<const char*>(front.payload.data()), front.payload.size());
+    noteConsumed(front.from, front.payload.size());
+    pendingRouter_.pop_front();
+    return true;
+}
+
+bool Communicator::routerReceive(int& fromId, zmq::message_t& payload, int timeoutMs) {
+    if (!router_) return false;
+    const ReceiveTimer timer(*this);
+    SC_TRACE_SCOPE(trace, Recv, id, -1, 0);
+    if (pendingRouter_.empty()) {
+        const auto deadline = deadlineAfter(timeoutMs);
+        while (pendingRouter_.empty()) {
+            if (pumpRouter(deadline) == Pumped::Nothing) return false;
+        }
+    }
+    fromId = pendingRouter_.front().from;
+    payload = std::move(pendingRouter_.front().payload);
+    pendingRouter_.pop_front();
+    SC_TRACE_SET(trace, fromId, payload.size());
+    noteConsumed(fromId, payload.size());
+    return true;
+}
+
+bool Communicator::routerReceiveFrom(int peerId, zmq::message_t& payload, int timeoutMs) {
+    if (!router_) return false;
+    const ReceiveTimer timer(*this);
+    SC_TRACE_SCOPE(trace, Recv, id, peerId, 0);
+    for (auto it = pendingRouter_.begin(); it != pendingRouter_.end(); ++it) {
+        if (it->from != peerId) continue;
+        payload = std::move(it->payload);
+        pendingRouter_.erase(it);
+        SC_TRACE_SET(trace, peerId, payload.size());
+        noteConsumed(peerId, payload.size());
+        return true;
+    }
+
+    // Other peers' messages stay parked in pendingRouter_ for later receives
+    const auto deadline = deadlineAfter(timeoutMs);
+    while (true) {
+        const Pumped got = pumpRouter(deadline);
+        if (got == Pumped::Nothing) return false;
+        if (got == Pumped::Untagged && pendingRouter_.back().from == peerId) {
+            payload = std::move(pendingRouter_.back().payload);
+            pendingRouter_.pop_back();
+            SC_TRACE_SET(trace, peerId, payload.size());
+            noteConsumed(peerId, payload.size());
+            return true;
+        }
+    }
+}
+
+bool Communicator::routerReceiveFromAll(std::vector<zmq::message_t>& payloads, std::vector<int>& missing, int timeoutMs) {
+    missing.clear();
+    if (!router_) return false;
+    const ReceiveTimer timer(*this);
+    SC_TRACE_SCOPE(trace, Recv, id, -1, 0); // whole gather; peer -1
+
+    const size_t slots = ids.size() + 1; // indexed by party id; slot 0 unused
+    if (payloads.size() != slots) payloads.resize(slots);
+    size_t outstanding = resetGatherSlots(slots);
+
+    auto take = [&](int fromId, zmq::message_t& msg) -> bool {
+        if (fromId <= 0 || static_cast<size_t>(fromId) >= slots || gatherFilled_[fromId]) return false;
+        payloads[fromId] = std::move(msg);
+        gatherFilled_[fromId] = 1;
+        --outstanding;
+        return true;
+    };
+
+    // Messages parked by earlier per-peer receives count first, oldest first
+    for (auto it = pendingRouter_.begin(); it != pendingRouter_.end() && outstanding > 0;) {
+        if (take(it->from, it->payload)) it = pendingRouter_.erase(it);
+        else ++it;
+    }
+
+    // One deadline for the whole gather; drain the socket without per-message timeouts.
+    // A second message from a peer already gathered belongs to a later round and stays parked.
+    const auto deadline = deadlineAfter(timeoutMs);
+    while (outstanding > 0) {
+        const Pumped got = pumpRouter(deadline);
+        if (got == Pumped::Nothing) break;
+        if (got == Pumped::Untagged && take(pendingRouter_.back().from, pendingRouter_.back().payload)) {
+            pendingRouter_.pop_back();
+        }
+    }
+
+    noteGathered(payloads, slots);
+    collectMissing(slots, missing);
+    return missing.empty();
+}
+
+size_t Communicator::resetGatherSlots(size_t slots) {
+    gatherFilled_.assign(slots, 0);
+    gatherFilled_[0] = 1;
+    if (this->id > 0 && static_cast<size_t>(this->id) < slots) gatherFilled_[this->id] = 1; // never expect self
+    size_t outstanding = 0;
+    for (size_t i = 1; i < slots; ++i) if (!gatherFilled_[i]) ++outstanding;
+    return outstanding;
+}
+
+void Communicator::collectMissing(size_t slots, std::vector<int>& missing) const {
+    for (size_t i = 1; i < slots; ++i) {
+        if (!gatherFilled_[i]) missing.push_back(static_cast<int>(i));
+    }
+}
+
+void Communicator::noteGathered(const std::vector<zmq::message_t>& payloads, size_t slots) {
+    for (size_t i = 1; i < slots; ++i) {
+        if (gatherFilled_[i]) noteConsumed(static_cast<int>(i), payloads[i].size());
+    }
+}
+
+void Communicator::setSession(uint32_t session) noexcept {
+    session_ = session;
+}
+
+bool Communicator::dealerSendRound(int peerId, uint32_t round, const std::string& payload) {
+    return dealerSendRound(peerId, round, copyMessage(payload.data(), payload.size()));
+}
 
-    fromIdentity = identity.to_string();
-    payload.assign(static_cast<const char*>(payloadMsg.data()), payloadMsg.size());
+bool Communicator::dealerSendRound(int peerId, uint32_t round, zmq::message_t&& payload) {
+    if (peerId <= 0 || static_cast<size_t>(peerId) > ids.size()) return false;
+    if (roundSendSeq_.size() != ids.size() + 1) roundSendSeq_.assign(ids.size() + 1, 0);
+
+    wire::RoundHeader h;
+    h.session = session_;
+    h.round = round;
+    h.seq = roundSendSeq_[peerId];
+    zmq::message_t header(wire::kRoundHeaderSize);
+    wire::encodeRoundHeader(h, static_cast<uint8_t*>(header.data()));
+    if (!sendTagged(peerId, header, std::move(payload))) return false;
+    ++roundSendSeq_[peerId];
+    return true;
+}
+
+bool Communicator::routerReceiveRound(int peerId, uint32_t round, zmq::message_t& payload, int timeoutMs) {
+    if (!router_) return false;
+    const ReceiveTimer timer(*this);
+    SC_TRACE_SCOPE(trace, Recv, id, peerId, 0);
+    const auto key = std::make_pair(peerId, round);
+    const auto deadline = deadlineAfter(timeoutMs);
+    while (true) {
+        auto it = reorder_.find(key);
+        if (it != reorder_.end()) {
+            payload = std::move(it->second.front());
+            it->second.pop_front();
+            if (it->second.empty()) reorder_.erase(it);
+            SC_TRACE_SET(trace, peerId, payload.size());
+            noteConsumed(peerId, payload.size());
+            return true;
+        }
+        if (pumpRouter(deadline) == Pumped::Nothing) return false;
+    }
+}
+
+bool Communicator::routerReceiveRoundFromAll(uint32_t round, std::vector<zmq::message_t>& payloads, std::vector<int>& missing, int timeoutMs) {
+    missing.clear();
+    if (!router_) return false;
+    const ReceiveTimer timer(*this);
+    SC_TRACE_SCOPE(trace, Recv, id, -1, 0); // whole gather; peer -1
+
+    const size_t slots = ids.size() + 1;
+    if (payloads.size() != slots) payloads.resize(slots);
+    size_t outstanding = resetGatherSlots(slots);
+
+    auto takeBuffered = [&](size_t peer) {
+        auto it = reorder_.find(std::make_pair(static_cast<int>(peer), round));
+        if (it == reorder_.end()) return;
+        payloads[peer] = std::move(it->second.front());
+        it->second.pop_front();
+        if (it->second.empty()) reorder_.erase(it);
+        gatherFilled_[peer] = 1;
+        --outstanding;
+    };
+
+    const auto deadline = deadlineAfter(timeoutMs);
+    while (true) {
+        for (size_t peer = 1; peer < slots && outstanding > 0; ++peer) {
+            if (!gatherFilled_[peer]) takeBuffered(peer);
+        }
+        if (outstanding == 0) break;
+        if (pumpRouter(deadline) == Pumped::Nothing) break;
+    }
+
+    noteGathered(payloads, slots);
+    collectMissing(slots, missing);
+    return missing.empty();
+}
+
+namespace {
+// Keeps a streamed payload alive until zmq has released every chunk that points into it
+struct SharedPayload {
+    zmq::message_t msg;
+    std::atomic<int> refs{1};
+    void release() noexcept {
+        if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+    }
+};
+// zmq calls this from its I/O thread once a chunk has been sent
+void releaseChunk(void*, void* hint) {
+    static_cast<SharedPayload*>(hint)->release();
+}
+} // namespace
+
+bool Communicator::streamSend(int peerId, uint32_t streamId, const std::string& payload) {
+    return streamSend(peerId, streamId, copyMessage(payload.data(), payload.size()));
+}
+
+bool Communicator::streamSend(int peerId, uint32_t streamId, zmq::message_t&& payload) {
+    const size_t total = payload.size();
+    const size_t count = std::max<size_t>(1, (total + chunkSize_ - 1) / chunkSize_);
+    if (count > UINT32_MAX) return false;
+
+    auto* shared = new SharedPayload();
+    shared->msg = std::move(payload);
+    auto* base = static_cast<uint8_t*>(shared->msg.data());
+    StreamChunk info;
+    info.count = static_cast<uint32_t>(count);
+    info.total = total;
+    bool ok = true;
+    for (size_t i = 0; i < count && ok; ++i) {
+        info.index = static_cast<uint32_t>(i);
+        info.offset = i * chunkSize_;
+        const size_t len = std::min(chunkSize_, total - static_cast<size_t>(info.offset));
+        if (len == 0) { // zmq would not call the free function for an empty buffer
+            ok = sendChunk(peerId, streamId, info, zmq::message_t());
+            continue;
+        }
+        shared->refs.fetch_add(1, std::memory_order_relaxed);
+        ok = sendChunk(peerId, streamId, info, zmq::message_t(base + info.offset, len, releaseChunk, shared));
+    }
+    shared->release(); // drop the sender's own reference
+    return ok;
+}
+
+bool Communicator::sendChunk(int peerId, uint32_t streamId, const StreamChunk& chunk, zmq::message_t&& data) {
+    wire::ChunkHeader h;
+    h.session = session_;
+    h.stream = streamId;
+    h.index = chunk.index;
+    h.count = chunk.count;
+    h.offset = chunk.offset;
+    h.total = chunk.total;
+    zmq::message_t header(wire::kChunkHeaderSize);
+    wire::encodeChunkHeader(h, static_cast<uint8_t*>(header.data()));
+    return sendTagged(peerId, header, std::move(data));
+}
+
+bool Communicator::streamReceiveChunk(int peerId, uint32_t streamId, StreamChunk& chunk, int timeoutMs) {
+    if (!router_) return false;
+    const ReceiveTimer timer(*this);
+    const auto key = std::make_pair(peerId, streamId);
+    const auto deadline = deadlineAfter(timeoutMs);
+    while (true) {
+        auto it = streams_.find(key);
+        if (it != streams_.end()) {
+            chunk = std::move(it->second.front());
+            it->second.pop_front();
+            if (it->second.empty()) streams_.erase(it);
+            noteConsumed(peerId, chunk.data.size());
+            return true;
+        }
+        if (pumpRouter(deadline) == Pumped::Nothing) return false;
+    }
+}
+
+bool Communicator::streamReceive(int peerId, uint32_t streamId, const ChunkHandler& onChunk, int timeoutMs) {
+    StreamChunk chunk;
+    do {
+        if (!streamReceiveChunk(peerId, streamId, chunk, timeoutMs)) return false;
+        onChunk(chunk);
+    } while (!chunk.last());
+    return true;
+}
+
+bool Communicator::streamReceive(int peerId, uint32_t streamId, zmq::message_t& payload, int timeoutMs) {
+    bool sized = false;
+    bool ok = true;
+    const bool done = streamReceive(peerId, streamId, [&](const StreamChunk& c) {
+        if (!sized) {
+            payload.rebuild(static_cast<size_t>(c.total));
+            sized = true;
+        }
+        if (c.total != payload.size() || c.offset + c.data.size() > payload.size()) {
+            ok = false;
+            return;
+        }
+        std::memcpy(static_cast<uint8_t*>(payload.data()) + c.offset, c.data.data(), c.data.size());
+    }, timeoutMs);
+    return done && ok;
+}
+
+bool Communicator::streamRelay(int fromPeer, uint32_t streamId, const std::vector<int>& forwardTo,
+                               const ChunkHandler& onChunk, int timeoutMs) {
+    bool ok = true;
+    StreamChunk chunk;
+    do {
+        if (!streamReceiveChunk(fromPeer, streamId, chunk, timeoutMs)) return false;
+        for (int peer : forwardTo) {
+            zmq::message_t share;
+            share.copy(chunk.data); // ref-counted, no byte copy
+            if (!sendChunk(peer, streamId, chunk, std::move(share))) ok = false;
+        }
+        if (onChunk) onChunk(chunk);
+    } while (!chunk.last());
+    return ok;
+}
+
+bool Communicator::sendTagged(int peerId, zmq::message_t& header, zmq::message_t&& payload) {
+    const auto started = metricsNow();
+    const size_t bytes = payload.size();
+    SC_TRACE_SCOPE(trace, Send, id, peerId, bytes);
+    bool ok = false;
+    if (flowBudget_ == 0) {
+        ok = rawSendTagged(peerId, header, std::move(payload));
+    } else if (acquireCredit(peerId, bytes, deadlineAfter(creditTimeoutMs_))) {
+        ok = rawSendTagged(peerId, header, std::move(payload));
+        if (!ok) refundCredit(peerId, bytes);
+    }
+    noteSent(peerId, bytes, ok, started);
+    return ok;
+}
+
+bool Communicator::rawSendTagged(int peerId, zmq::message_t& header, zmq::message_t&& payload) {
+    if (mesh_) return meshSend(peerId, &header, std::move(payload), deadlineAfter(creditTimeoutMs_));
+    if (peerId == this->id) return false;
+    auto it = perPeerDealer_.find(peerId);
+    if (it == perPeerDealer_.end() || !it->second) return false; // not prepared
+    auto& sockPtr = it->second;
+    // [header][payload] is delivered atomically; the payload frame is not copied
+    if (!sockPtr->send(header, zmq::send_flags::sndmore | zmq::send_flags::dontwait)) return false;
+    auto rc = sockPtr->send(std::move(payload), zmq::send_flags::dontwait);
+    return rc.has_value();
+}
+
+int Communicator::waitInbound(int timeoutMs, int fd) {
+    return waitInbound(timeoutMs, fd, true);
+}
+
+int Communicator::waitInbound(int timeoutMs, int fd, bool countBuffered) {
+    zmq::pollitem_t items[3];
+    int n = 0;
+    int routerIdx = -1, subIdx = -1, fdIdx = -1;
+    if (router_) { routerIdx = n; items[n++] = {router_->handle(), 0, ZMQ_POLLIN, 0}; }
+    if (sub_) { subIdx = n; items[n++] = {sub_->handle(), 0, ZMQ_POLLIN, 0}; }
+    if (fd >= 0) { fdIdx = n; items[n++] = {nullptr, fd, ZMQ_POLLIN, 0}; }
+    if (n == 0) return 0;
+
+    // Already-buffered ROUTER messages must not wait behind the poll timeout
+    const bool buffered = countBuffered && (!pendingRouter_.empty() || !pendingSub_.empty());
+    const long waitMs = buffered ? 0 : (timeoutMs < 0 ? -1 : static_cast<long>(timeoutMs));
+    spinPoll(items, static_cast<size_t>(n), waitMs);
+
+    int mask = 0;
+    if (countBuffered && !pendingRouter_.empty()) mask |= kRouterReady;
+    if (countBuffered && !pendingSub_.empty()) mask |= kSubReady;
+    if (routerIdx >= 0 && (items[routerIdx].revents & ZMQ_POLLIN)) mask |= kRouterReady;
+    if (subIdx >= 0 && (items[subIdx].revents & ZMQ_POLLIN)) mask |= kSubReady;
+    if (fdIdx >= 0 && (items[fdIdx].revents & ZMQ_POLLIN)) mask |= kFdReady;
+    return mask;
+}
+
+void Communicator::rebuildPollSet() {
+    pollItems_.clear();
+    pollSources_.clear();
+    if (router_) {
+        pollItems_.push_back({router_->handle(), 0, ZMQ_POLLIN, 0});
+        pollSources_.push_back(0);
+    }
+    if (sub_) {
+        pollItems_.push_back({sub_->handle(), 0, ZMQ_POLLIN, 0});
+        pollSources_.push_back(-1);
+    }
+    for (int peerId : ids) {
+        auto it = perPeerDealer_.find(peerId);
+        if (it == perPeerDealer_.end() || !it->second) continue;
+        pollItems_.push_back({it->second->handle(), 0, ZMQ_POLLIN, 0});
+        pollSources_.push_back(peerId);
+    }
+    pollSetDirty_ = false;
+}
+
+int Communicator::poll(const PollHandlers& handlers, int timeoutMs) {
+    if (pollSetDirty_) rebuildPollSet();
+    const ReceiveTimer timer(*this);
+    int dispatched = 0;
+
+    // Messages an earlier receive already pulled off the ROUTER go first
+    if (handlers.onRouter) {
+        while (!pendingRouter_.empty()) {
+            // Taken off the queue first: the handler may move the message out or call a receive
+            PendingRouter m = std::move(pendingRouter_.front());
+            pendingRouter_.pop_front();
+            const size_t bytes = m.payload.size();
+            handlers.onRouter(m.from, m.payload);
+            noteConsumed(m.from, bytes);
+            ++dispatched;
+        }
+    }
+    if (handlers.onSub) {
+        while (!pendingSub_.empty()) {
+            auto m = std::move(pendingSub_.front());
+            pendingSub_.pop_front();
+            const int fromId = parsePartyId(m.first);
+            noteSubReceived(fromId, m.second.size(), recvStart_);
+            handlers.onSub(fromId, m.second);
+            ++dispatched;
+        }
+    }
+    if (pollItems_.empty()) return dispatched;
+
+    // Only sources with a handler are polled; the rest keep their messages queued
+    bool anyWanted = false;
+    for (size_t i = 0; i < pollItems_.size(); ++i) {
+        const int src = pollSources_[i];
+        const bool wanted = src == 0 ? static_cast<bool>(handlers.onRouter)
+                          : src < 0 ? static_cast<bool>(handlers.onSub)
+                                    : static_cast<bool>(handlers.onDealerReply);
+        pollItems_[i].events = wanted ? ZMQ_POLLIN : 0;
+        anyWanted = anyWanted || wanted;
+    }
+    if (!anyWanted) return dispatched; // nothing could ever wake the poll
+
+    const auto deadline = deadlineAfter(timeoutMs);
+    zmq::message_t aux;
+    zmq::message_t msg;
+    while (true) {
+        long waitMs = -1;
+        if (dispatched > 0) {
+            waitMs = 0; // already have work for the caller; just sweep what else is ready
+        } else if (deadline != Clock::time_point::max()) {
+            const auto left = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - Clock::now()).count();
+            waitMs = left > 0 ? static_cast<long>(left) : 0;
+        }
+        spinPoll(pollItems_.data(), pollItems_.size(), waitMs);
+
+        for (size_t i = 0; i < pollItems_.size(); ++i) {
+            if (!(pollItems_[i].revents & ZMQ_POLLIN)) continue;
+            const int src = pollSources_[i];
+            if (src == 0) {
+                // Tagged (round) messages are routed to their own buffers by the pump
+                Pumped got;
+                while ((got = pumpRouter(Clock::time_point::min())) != Pumped::Nothing) {
+                    if (got != Pumped::Untagged) continue;
+                    PendingRouter m = std::move(pendingRouter_.back());
+                    pendingRouter_.pop_back();
+                    const size_t bytes = m.payload.size();
+                    handlers.onRouter(m.from, m.payload);
+                    noteConsumed(m.from, bytes);
+                    ++dispatched;
+                }
+            } else if (src < 0) {
+                while (readSubFrames(aux, msg, zmq::recv_flags::dontwait)) {
+                    const int fromId = parsePartyId(aux);
+                    noteSubReceived(fromId, msg.size(), recvStart_);
+                    handlers.onSub(fromId, msg);
+                    ++dispatched;
+                }
+            } else {
+                auto& sock = *perPeerDealer_[src];
+                while (sock.recv(msg, zmq::recv_flags::dontwait)) {
+                    // ROUTER replies arrive as [payload] (or [empty][payload]); keep the last frame
+                    while (msg.more()) {
+                        if (!sock.recv(msg, zmq::recv_flags::none)) break;
+                    }
+                    handlers.onDealerReply(src, msg);
+                    ++dispatched;
+                }
+            }
+        }
+        if (dispatched > 0 || Clock::now() >= deadline) return dispatched;
+    }
+}
+
+bool Communicator::queue(int peerId, const void* data, size_t len) {
+    if (peerId <= 0 || peerId == this->id || static_cast<size_t>(peerId) > ids.size()) return false;
+    if (len > UINT32_MAX) return false;
+    if (coalesce_.size() != ids.size() + 1) coalesce_.resize(ids.size() + 1);
+
+    auto& buf = coalesce_[peerId];
+    const size_t at = buf.size();
+    buf.resize(at + MessageCursor::kRecordPrefix + len);
+    wire::storeLE32(buf.data() + at, static_cast<uint32_t>(len));
+    if (len > 0) std::memcpy(buf.data() + at + MessageCursor::kRecordPrefix, data, len);
+
+    if (buf.size() >= coalesceThreshold_) return flush(peerId);
+    return true;
+}
+
+bool Communicator::flush(int peerId) {
+    if (peerId <= 0 || static_cast<size_t>(peerId) >= coalesce_.size()) return true; // nothing queued
+    auto& buf = coalesce_[peerId];
+    if (buf.empty()) return true;
+    if (!dealerSendTo(peerId, copyMessage(buf.data(), buf.size()))) return false; // records stay queued for a retry
+    buf.clear(); // keeps capacity, so steady-state rounds do not reallocate
+    return true;
+}
+
+bool Communicator::flushAll() {
+    bool allOk = true;
+    for (size_t peerId = 1; peerId < coalesce_.size(); ++peerId) {
+        if (!flush(static_cast<int>(peerId))) allOk = false;
+    }
+    return allOk;
+}
+
+zmq::message_t Communicator::allocMessage(size_t bytes) {
+    if (!poolEnabled_ || bytes <= kInlineMessage) return zmq::message_t(bytes);
+    return zmq::message_t(pool_.allocate(bytes), bytes, &BufferPool::freeFn, nullptr);
+}
+
+zmq::message_t Communicator::copyMessage(const void* data, size_t bytes) {
+    if (!poolEnabled_ || bytes <= kInlineMessage) return zmq::message_t(data, bytes);
+    PooledBuffer buf(pool_, bytes);
+    std::memcpy(buf.data(), data, bytes);
+    return zmq::message_t(buf.release(), bytes, &BufferPool::freeFn, nullptr);
+}
+
+bool Communicator::sendVec(int peerId, const uint64_t* data, size_t count) {
+    zmq::message_t msg = allocMessage(count * sizeof(uint64_t));
+    wire::encodeU64LE(data, count, static_cast<uint8_t*>(msg.data()));
+    return dealerSendTo(peerId, std::move(msg));
+}
+
+bool Communicator::recvVec(int peerId, std::vector<uint64_t>& out, int timeoutMs) {
+    zmq::message_t msg;
+    if (!routerReceiveFrom(peerId, msg, timeoutMs)) return false;
+    if (msg.size() % sizeof(uint64_t) != 0) return false;
+    out.resize(msg.size() / sizeof(uint64_t));
+    wire::decodeU64LE(static_cast<const uint8_t*>(msg.data()), out.size(), out.data());
+    return true;
+}
+
+bool Communicator::sendPacked(int peerId, const uint64_t* data, size_t count, unsigned bits) {
+    if (bits == 0 || bits > 64) return false;
+    zmq::message_t msg = allocMessage(sizeof(uint64_t) + fieldpack::packedSize(count, bits));
+    auto* p = static_cast<uint8_t*>(msg.data());
+    wire::storeLE64(p, count);
+    fieldpack::pack(data, count, bits, p + sizeof(uint64_t));
+    return dealerSendTo(peerId, std::move(msg));
+}
+
+bool Communicator::recvPacked(int peerId, std::vector<uint64_t>& out, unsigned bits, int timeoutMs) {
+    if (bits == 0 || bits > 64) return false;
+    zmq::message_t msg;
+    if (!routerReceiveFrom(peerId, msg, timeoutMs)) return false;
+    if (msg.size() < sizeof(uint64_t)) return false;
+    const auto* p = static_cast<const uint8_t*>(msg.data());
+    const uint64_t count = wire::loadLE64(p);
+    // Bound count by the payload before sizing anything from it
+    if (count > (msg.size() - sizeof(uint64_t)) * 8 / bits) return false;
+    if (msg.size() != sizeof(uint64_t) + fieldpack::packedSize(count, bits)) return false;
+    out.resize(count);
+    fieldpack::unpack(p + sizeof(uint64_t), out.size(), bits, out.data());
     return true;
 }
 
@@ -217,19 +1191,115 @@ bool Communicator::routerSend(const std::string& toIdentity, const std::string&
 // }
 
 bool Communicator::dealerSendTo(int peerId, const std::string& payload) {
-    if (peerId == this->id) return false;
+    // Same path as the message overload, so flow control applies to it too
+    return dealerSendTo(peerId, copyMessage(payload.data(), payload.size()));
+}
 
-    auto it = perPeerDealer_.find(peerId);
-    if (it == perPeerDealer_.end() || !it->second) return false; // not prepared
-    auto& sockPtr = it->second;
+bool Communicator::dealerSendTo(int peerId, zmq::message_t&& payload) {
+    const auto started = metricsNow();
+    const size_t bytes = payload.size();
+    SC_TRACE_SCOPE(trace, Send, id, peerId, bytes);
+    bool ok = false;
+    if (flowBudget_ == 0) {
+        ok = rawDealerSend(peerId, std::move(payload));
+    } else if (acquireCredit(peerId, bytes, deadlineAfter(creditTimeoutMs_))) {
+        ok = rawDealerSend(peerId, std::move(payload));
+        if (!ok) refundCredit(peerId, bytes);
+    }
+    noteSent(peerId, bytes, ok, started);
+    return ok;
+}
 
-    zmq::message_t msg(payload.begin(), payload.end());
-    auto rc = sockPtr->send(msg, zmq::send_flags::dontwait);
-    if (rc.has_value()) return true;
-    return false;
+Communicator::SendResult Communicator::trySendTo(int peerId, zmq::message_t&& payload) {
+    if (flowBudget_ > 0) {
+        const size_t bytes = payload.size();
+        if (!hasCredit(peerId, bytes)) {
+            // Pick up any grants that already arrived, without waiting
+            while (router_ && pumpRouter(Clock::time_point::min()) != Pumped::Nothing) {}
+            if (!hasCredit(peerId, bytes)) return SendResult::WouldBlock;
+        }
+        sendCredit_[peerId] -= static_cast<int64_t>(bytes);
+    }
+    // WouldBlock is backpressure, not a failure, so only attempts that reach the socket are counted
+    const auto started = metricsNow();
+    const size_t bytes = payload.size();
+    const bool ok = rawDealerSend(peerId, std::move(payload));
+    if (!ok && flowBudget_ > 0) refundCredit(peerId, bytes);
+    noteSent(peerId, bytes, ok, started);
+    return ok ? SendResult::Ok : SendResult::Error;
 }
 
-bool Communicator::dealerSendTo(int peerId, zmq::message_t&& payload) {
+void Communicator::setFlowBudget(size_t bytesPerPeer) {
+    flowBudget_ = bytesPerPeer;
+    sendCredit_.assign(ids.size() + 1, static_cast<int64_t>(bytesPerPeer));
+    consumed_.assign(ids.size() + 1, 0);
+}
+
+bool Communicator::hasCredit(int peerId, size_t bytes) const noexcept {
+    if (peerId <= 0 || static_cast<size_t>(peerId) >= sendCredit_.size()) return false;
+    // An oversized message needs the whole budget, i.e. nothing outstanding
+    return sendCredit_[peerId] >= static_cast<int64_t>(std::min(bytes, flowBudget_));
+}
+
+int64_t Communicator::availableCredit(int peerId) const noexcept {
+    if (flowBudget_ == 0) return static_cast<int64_t>(INT64_MAX);
+    if (peerId <= 0 || static_cast<size_t>(peerId) >= sendCredit_.size()) return 0;
+    return sendCredit_[peerId];
+}
+
+bool Communicator::waitForCredit(int peerId, size_t bytes, int timeoutMs) {
+    if (flowBudget_ == 0) return true;
+    if (peerId <= 0 || static_cast<size_t>(peerId) >= sendCredit_.size() || !router_) return false;
+    const auto deadline = deadlineAfter(timeoutMs);
+    while (!hasCredit(peerId, bytes)) {
+        if (pumpRouter(deadline) == Pumped::Nothing) return false;
+    }
+    return true;
+}
+
+bool Communicator::acquireCredit(int peerId, size_t bytes, Clock::time_point deadline) {
+    if (flowBudget_ == 0) return true;
+    if (peerId <= 0 || static_cast<size_t>(peerId) >= sendCredit_.size() || !router_) return false;
+    while (!hasCredit(peerId, bytes)) {
+        if (pumpRouter(deadline) == Pumped::Nothing) return false;
+    }
+    sendCredit_[peerId] -= static_cast<int64_t>(bytes);
+    return true;
+}
+
+void Communicator::refundCredit(int peerId, size_t bytes) noexcept {
+    if (flowBudget_ > 0) sendCredit_[peerId] += static_cast<int64_t>(bytes);
+}
+
+void Communicator::noteConsumed(int fromId, size_t bytes) {
+    if (PeerCounters* c = peerCounters(fromId)) {
+        c->messagesReceived.fetch_add(1, std::memory_order_relaxed);
+        c->bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+    }
+    if (flowBudget_ == 0 || fromId <= 0 || static_cast<size_t>(fromId) >= consumed_.size()) return;
+    consumed_[fromId] += bytes;
+    if (consumed_[fromId] < std::max<size_t>(1, flowBudget_ / 2)) return;
+    wire::CreditHeader h;
+    h.session = session_;
+    h.bytes = consumed_[fromId];
+    zmq::message_t header(wire::kCreditHeaderSize);
+    wire::encodeCreditHeader(h, static_cast<uint8_t*>(header.data()));
+    // A grant that cannot be sent now is kept and folded into the next one
+    if (rawSendTagged(fromId, header, zmq::message_t())) consumed_[fromId] = 0;
+}
+
+void Communicator::returnStaleCredit(int fromId, uint32_t session, size_t bytes) {
+    if (flowBudget_ == 0 || bytes == 0 || !knownPeer(fromId)) return;
+    wire::CreditHeader h;
+    h.session = session;
+    h.bytes = bytes;
+    zmq::message_t header(wire::kCreditHeaderSize);
+    wire::encodeCreditHeader(h, static_cast<uint8_t*>(header.data()));
+    rawSendTagged(fromId, header, zmq::message_t());
+}
+
+bool Communicator::rawDealerSend(int peerId, zmq::message_t&& payload) {
+    if (mesh_) return meshSend(peerId, nullptr, std::move(payload), deadlineAfter(creditTimeoutMs_));
     if (peerId == this->id) return false;
 
     auto it = perPeerDealer_.find(peerId);
@@ -242,19 +1312,135 @@ bool Communicator::dealerSendTo(int peerId, zmq::message_t&& payload) {
 }
 
 bool Communicator::pubBroadcast(const std::string& payload) {
+    return pubBroadcast(copyMessage(payload.data(), payload.size()));
+}
+
+bool Communicator::pubBroadcast(zmq::message_t&& payload) {
     if (!pub_) return false;
-    zmq::message_t data(payload.begin(), payload.end());
-    auto s = pub_->send(data, zmq::send_flags::dontwait);
+    SC_TRACE_SCOPE(trace, Publish, id, -1, payload.size());
+    const std::string topicStr = std::to_string(id);
+    zmq::message_t topic(topicStr.data(), topicStr.size());
+    if (!pub_->send(topic, zmq::send_flags::sndmore | zmq::send_flags::dontwait)) return false;
+    auto s = pub_->send(std::move(payload), zmq::send_flags::dontwait);
     return s.has_value();
 }
 
-bool Communicator::subReceive(std::string& fromPublisherId, std::string& payload, int timeoutMs) {
+bool Communicator::readSubFrames(zmq::message_t& topic, zmq::message_t& payload, zmq::recv_flags flags) {
+    while (true) {
+        // PUB side sends [topic][payload]
+        if (!sub_->recv(topic, flags)) return false;
+        if (!topic.more()) {
+            // Single-frame publisher (no topic): the only frame is the payload
+            payload = std::move(topic);
+            topic.rebuild();
+            return true;
+        }
+        if (!sub_->recv(payload, zmq::recv_flags::none)) return false;
+        if (!payload.more()) return true;
+        // [topic][control header][empty] is a readiness beacon, not application data
+        zmq::message_t tail;
+        do {
+            if (!sub_->recv(tail, zmq::recv_flags::none)) return false;
+        } while (tail.more());
+        handleBeacon(parsePartyId(topic), payload);
+    }
+}
+
+bool Communicator::recvSubFrames(zmq::message_t& topic, zmq::message_t& payload, int timeoutMs) {
     if (!sub_) return false;
-    if (timeoutMs >= 0) sub_->set(zmq::sockopt::rcvtimeo, timeoutMs);
+    const auto started = metricsNow();
+    SC_TRACE_SCOPE(trace, SubRecv, id, -1, 0);
+    if (!pendingSub_.empty()) {
+        topic = std::move(pendingSub_.front().first);
+        payload = std::move(pendingSub_.front().second);
+        pendingSub_.pop_front();
+    } else {
+        const int wanted = timeoutMs < 0 ? -1 : timeoutMs;
+        if (wanted != subRcvTimeo_) {
+            sub_->set(zmq::sockopt::rcvtimeo, wanted);
+            subRcvTimeo_ = wanted;
+        }
+        bool got = false;
+        bool timedOut = false;
+        if (spinUs_ > 0 && timeoutMs != 0) {
+            // The spin never outlasts the caller's timeout; if it covers all of it, it is the whole wait
+            long long spin = spinUs_;
+            if (timeoutMs > 0 && spin >= 1000LL * timeoutMs) {
+                spin = 1000LL * timeoutMs;
+                timedOut = true;
+            }
+            const auto spinUntil = Clock::now() + std::chrono::microseconds(spin);
+            while (!(got = readSubFrames(topic, payload, zmq::recv_flags::dontwait)) && Clock::now() < spinUntil) cpu::relax();
+        }
+        if (!got && (timedOut || !readSubFrames(topic, payload, zmq::recv_flags::none))) return false;
+    }
+    const int fromId = parsePartyId(topic);
+    SC_TRACE_SET(trace, fromId, payload.size());
+    noteSubReceived(fromId, payload.size(), started);
+    return true;
+}
+
+bool Communicator::subReceive(std::string& fromPublisherId, std::string& payload, int timeoutMs) {
+    zmq::message_t topic;
     zmq::message_t data;
-    auto r = sub_->recv(data, zmq::recv_flags::none);
-    if (!r.has_value()) return false;
-    fromPublisherId.clear();
+    if (!recvSubFrames(topic, data, timeoutMs)) return false;
+    fromPublisherId = topic.to_string();
     payload.assign(static_cast<const char*>(data.data()), data.size());
     return true;
-}
\ No newline at end of file
+}
+
+bool Communicator::subReceive(int& fromPublisherId, zmq::message_t& payload, int timeoutMs) {
+    zmq::message_t topic;
+    if (!recvSubFrames(topic, payload, timeoutMs)) return false;
+    fromPublisherId = parsePartyId(topic);
+    return true;
+}
+
+void Communicator::noteSent(int peerId, size_t bytes, bool ok, Clock::time_point started) noexcept {
+    PeerCounters* c = peerCounters(peerId);
+    if (!c) return;
+    if (ok) {
+        c->messagesSent.fetch_add(1, std::memory_order_relaxed);
+        c->bytesSent.fetch_add(bytes, std::memory_order_relaxed);
+    } else {
+        c->sendFailures.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (started != Clock::time_point::min()) {
+        c->sendLatency.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count()));
+    }
+}
+
+void Communicator::noteArrived(int fromId) noexcept {
+    PeerCounters* c = peerCounters(fromId);
+    if (!c) return;
+    c->messagesArrived.fetch_add(1, std::memory_order_relaxed);
+    // Pumps outside a receive call (credit waits, readiness) have no caller waiting on this peer
+    if (recvStart_ != Clock::time_point::min()) {
+        c->recvWait.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - recvStart_).count()));
+    }
+}
+
+void Communicator::noteSubReceived(int fromId, size_t bytes, Clock::time_point started) noexcept {
+    PeerCounters* c = peerCounters(fromId);
+    if (!c) return;
+    // Read straight off the SUB socket, so it arrives and is received at once
+    c->messagesArrived.fetch_add(1, std::memory_order_relaxed);
+    c->messagesReceived.fetch_add(1, std::memory_order_relaxed);
+    c->bytesReceived.fetch_add(bytes, std::memory_order_relaxed);
+    if (started != Clock::time_point::min()) {
+        c->recvWait.record(static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - started).count()));
+    }
+}
+
+std::vector<PeerMetrics> Communicator::metricsSnapshot() const {
+    std::vector<PeerMetrics> out;
+    for (size_t peer = 1; peer < metricsSlots_; ++peer) {
+        if (static_cast<int>(peer) == id) continue;
+        out.push_back(snapshotPeer(static_cast<int>(peer), metrics_[peer]));
+    }
+    return out;
+}
+
+void Communicator::resetMetrics() noexcept {
+    for (size_t peer = 0; peer < metricsSlots_; ++peer) metrics_[peer].reset();
+}
@@ -0,0 +1,85 @@
+#include "CpuAffinity.h"
+
+#include <sstream>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace cpu {
+
+namespace {
+
+#ifdef __linux__
+bool pinHandle(pthread_t handle, const std::vector<int>& cores) {
+    if (cores.empty()) return false;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (int core : cores) {
+        if (core < 0 || core >= CPU_SETSIZE) return false;
+        CPU_SET(core, &set);
+    }
+    return pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+}
+#endif
+
+// Cores a thread can be pinned to; anything from here up is rejected while parsing
+#ifdef __linux__
+constexpr int kMaxCores = CPU_SETSIZE;
+#else
+constexpr int kMaxCores = 1024;
+#endif
+
+bool parseInt(const std::string& s, int& out) {
+    if (s.empty() || s.size() > 6) return false;
+    int v = 0;
+    for (char c : s) {
+        if (c < '0' || c > '9') return false;
+        v = v * 10 + (c - '0');
+    }
+    out = v;
+    return true;
+}
+
+} // namespace
+
+bool pinCurrentThread(const std::vector<int>& cores) {
+#ifdef __linux__
+    return pinHandle(pthread_self(), cores);
+#else
+    (void)cores;
+    return false;
+#endif
+}
+
+bool pinThread(std::thread& t, const std::vector<int>& cores) {
+#ifdef __linux__
+    return t.joinable() && pinHandle(t.native_handle(), cores);
+#else
+    (void)t;
+    (void)cores;
+    return false;
+#endif
+}
+
+std::vector<int> parseCoreList(const std::string& spec) {
+    std::vector<int> cores;
+    std::stringstream ss(spec);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        const size_t dash = item.find('-');
+        int lo = 0, hi = 0;
+        if (dash == std::string::npos) {
+            if (!parseInt(item, lo)) return {};
+            hi = lo;
+        } else if (!parseInt(item.substr(0, dash), lo) || !parseInt(item.substr(dash + 1), hi) || hi < lo) {
+            return {};
+        }
+        if (hi >= kMaxCores) return {};
+        for (int c = lo; c <= hi; ++c) cores.push_back(c);
+    }
+    return cores;
+}
+
+} // namespace cpu
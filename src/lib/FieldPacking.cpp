@@ -0,0 +1,124 @@
+#include "FieldPacking.h"
+#include "WireFormat.h"
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+namespace fieldpack {
+
+namespace {
+
+inline uint64_t lowMask(unsigned bits) noexcept {
+    return bits >= 64 ? ~0ull : ((1ull << bits) - 1);
+}
+
+// Load up to 8 bytes little-endian, zero-padding past the end of the buffer
+inline uint64_t loadTail(const uint8_t* p, size_t avail) noexcept {
+    if (avail >= 8) return wire::loadLE64(p);
+    uint64_t w = 0;
+    for (size_t k = 0; k < avail; ++k) w |= static_cast<uint64_t>(p[k]) << (8 * k);
+    return w;
+}
+
+// Scalar reader: streams 64-bit words and peels `bits` at a time. Starts at a byte boundary.
+void unpackScalar(const uint8_t* in, size_t inBytes, size_t count, unsigned bits, uint64_t* out) noexcept {
+    const uint64_t mask = lowMask(bits);
+    uint64_t acc = 0;
+    unsigned avail = 0;
+    size_t ip = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (avail >= bits) {
+            out[i] = acc & mask;
+            acc = bits >= 64 ? 0 : acc >> bits;
+            avail -= bits;
+            continue;
+        }
+        const uint64_t w = loadTail(in + ip, inBytes - ip);
+        ip += 8;
+        const unsigned consumed = bits - avail; // 1..64 bits taken from w
+        out[i] = (acc | (avail >= 64 ? 0 : w << avail)) & mask;
+        acc = consumed >= 64 ? 0 : w >> consumed;
+        avail = 64 - consumed;
+    }
+}
+
+#ifdef __AVX2__
+// 8 values per step: every group of 8 values spans exactly `bits` bytes, so each lane can
+// gather the 8-byte window holding its value and shift it into place. Needs bits <= 57 so a
+// value plus its in-byte offset fits one window. Returns how many values were decoded.
+size_t unpackAvx2(const uint8_t* in, size_t inBytes, size_t count, unsigned bits, uint64_t* out) noexcept {
+    if (bits > 57 || count < 8) return 0;
+    long long byteOff[8];
+    long long shift[8];
+    for (unsigned j = 0; j < 8; ++j) {
+        byteOff[j] = static_cast<long long>((j * bits) >> 3);
+        shift[j] = static_cast<long long>((j * bits) & 7);
+    }
+    const __m256i idxLo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(byteOff));
+    const __m256i idxHi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(byteOff + 4));
+    const __m256i shLo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shift));
+    const __m256i shHi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(shift + 4));
+    const __m256i mask = _mm256_set1_epi64x(static_cast<long long>(lowMask(bits)));
+
+    // The last lane reads 8 bytes starting at byteOff[7]; stop before that would overrun
+    size_t i = 0;
+    size_t groupByte = 0;
+    while (i + 8 <= count && groupByte + static_cast<size_t>(byteOff[7]) + 8 <= inBytes) {
+        const auto* base = reinterpret_cast<const long long*>(in + groupByte);
+        const __m256i lo = _mm256_i64gather_epi64(base, idxLo, 1);
+        const __m256i hi = _mm256_i64gather_epi64(base, idxHi, 1);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), _mm256_and_si256(_mm256_srlv_epi64(lo, shLo), mask));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i + 4), _mm256_and_si256(_mm256_srlv_epi64(hi, shHi), mask));
+        i += 8;
+        groupByte += bits;
+    }
+    return i;
+}
+#endif
+
+} // namespace
+
+unsigned bitsFor(uint64_t modulus) noexcept {
+    if (modulus <= 2) return 1;
+    const uint64_t maxValue = modulus - 1;
+    return 64u - static_cast<unsigned>(__builtin_clzll(maxValue));
+}
+
+void pack(const uint64_t* in, size_t count, unsigned bits, uint8_t* out) noexcept {
+    // 64-bit accumulator; full words go out with one little-endian store. This loop is
+    // store-bound already, so it has no separate SIMD variant.
+    const uint64_t mask = lowMask(bits);
+    uint64_t acc = 0;
+    unsigned filled = 0;
+    size_t op = 0;
+    for (size_t i = 0; i < count; ++i) {
+        const uint64_t v = in[i] & mask;
+        acc |= v << filled;
+        const unsigned total = filled + bits;
+        if (total >= 64) {
+            wire::storeLE64(out + op, acc);
+            op += 8;
+            acc = filled == 0 ? 0 : v >> (64 - filled);
+            filled = total - 64;
+        } else {
+            filled = total;
+        }
+    }
+    for (unsigned k = 0; k < (filled + 7) / 8; ++k) {
+        out[op++] = static_cast<uint8_t>(acc >> (8 * k));
+    }
+}
+
+void unpack(const uint8_t* in, size_t count, unsigned bits, uint64_t* out) noexcept {
+    const size_t inBytes = packedSize(count, bits);
+    size_t done = 0;
+#ifdef __AVX2__
+    done = unpackAvx2(in, inBytes, count, bits, out);
+#endif
+    // done is a multiple of 8, so the remaining values start on a byte boundary
+    const size_t skip = (done * bits) / 8;
+    unpackScalar(in + skip, inBytes - skip, count - done, bits, out + done);
+}
+
+} // namespace fieldpack
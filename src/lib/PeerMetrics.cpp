@@ -0,0 +1,110 @@
+#include "PeerMetrics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <sstream>
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t b) noexcept {
+    if (b < (size_t(1) << kSubBits)) return b;
+    const unsigned e = static_cast<unsigned>(b >> kSubBits) + kSubBits - 1;
+    const uint64_t sub = b & ((size_t(1) << kSubBits) - 1);
+    const uint64_t width = uint64_t(1) << (e - kSubBits);
+    return (uint64_t(1) << e) + sub * width + width - 1;
+}
+
+LatencyHistogram::Snapshot LatencyHistogram::snapshot() const {
+    Snapshot s;
+    s.buckets.resize(kBuckets);
+    for (size_t b = 0; b < kBuckets; ++b) {
+        s.buckets[b] = buckets_[b].load(std::memory_order_relaxed);
+        s.count += s.buckets[b]; // counted from the buckets so percentile() always agrees with them
+    }
+    s.sumNs = sum_.load(std::memory_order_relaxed);
+    s.maxNs = max_.load(std::memory_order_relaxed);
+    return s;
+}
+
+void LatencyHistogram::reset() noexcept {
+    for (auto& b : buckets_) b.store(0, std::memory_order_relaxed);
+    sum_.store(0, std::memory_order_relaxed);
+    max_.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::Snapshot::percentile(double q) const noexcept {
+    if (count == 0 || buckets.empty()) return 0;
+    q = std::min(1.0, std::max(0.0, q));
+    const uint64_t rank = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(q * static_cast<double>(count))));
+    uint64_t seen = 0;
+    for (size_t b = 0; b < buckets.size(); ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return std::min(bucketUpperBound(b), maxNs);
+    }
+    return maxNs;
+}
+
+void PeerCounters::reset() noexcept {
+    for (auto* c : {&messagesSent, &bytesSent, &sendFailures, &messagesArrived, &messagesReceived, &bytesReceived}) {
+        c->store(0, std::memory_order_relaxed);
+    }
+    sendLatency.reset();
+    recvWait.reset();
+}
+
+PeerMetrics snapshotPeer(int peer, const PeerCounters& counters) {
+    PeerMetrics m;
+    m.peer = peer;
+    m.messagesSent = counters.messagesSent.load(std::memory_order_relaxed);
+    m.bytesSent = counters.bytesSent.load(std::memory_order_relaxed);
+    m.sendFailures = counters.sendFailures.load(std::memory_order_relaxed);
+    // Received before arrived, so a message landing in between cannot make the depth negative
+    m.messagesReceived = counters.messagesReceived.load(std::memory_order_relaxed);
+    m.bytesReceived = counters.bytesReceived.load(std::memory_order_relaxed);
+    const uint64_t arrived = counters.messagesArrived.load(std::memory_order_relaxed);
+    m.queueDepth = arrived > m.messagesReceived ? arrived - m.messagesReceived : 0;
+    m.sendLatency = counters.sendLatency.snapshot();
+    m.recvWait = counters.recvWait.snapshot();
+    return m;
+}
+
+namespace {
+
+void writeCounter(std::ostringstream& out, const char* name, const char* type, const char* help,
+                  int selfId, const std::vector<PeerMetrics>& peers, uint64_t PeerMetrics::*field) {
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << ' ' << type << '\n';
+    for (const auto& p : peers) {
+        out << name << "{party=\"" << selfId << "\",peer=\"" << p.peer << "\"} " << p.*field << '\n';
+    }
+}
+
+void writeSummary(std::ostringstream& out, const char* name, const char* help,
+                  int selfId, const std::vector<PeerMetrics>& peers, LatencyHistogram::Snapshot PeerMetrics::*field) {
+    static const struct { double q; const char* label; } kQuantiles[] = {
+        {0.5, "0.5"}, {0.9, "0.9"}, {0.99, "0.99"}, {0.999, "0.999"}};
+    out << "# HELP " << name << ' ' << help << '\n';
+    out << "# TYPE " << name << " summary\n";
+    for (const auto& p : peers) {
+        const auto& h = p.*field;
+        for (const auto& q : kQuantiles) {
+            out << name << "{party=\"" << selfId << "\",peer=\"" << p.peer << "\",quantile=\"" << q.label << "\"} "
+                << h.percentile(q.q) << '\n';
+        }
+        out << name << "_sum{party=\"" << selfId << "\",peer=\"" << p.peer << "\"} " << h.sumNs << '\n';
+        out << name << "_count{party=\"" << selfId << "\",peer=\"" << p.peer << "\"} " << h.count << '\n';
+    }
+}
+
+} // namespace
+
+std::string formatMetricsText(int selfId, const std::vector<PeerMetrics>& peers) {
+    std::ostringstream out;
+    writeCounter(out, "sc_messages_sent_total", "counter", "Messages sent to the peer.", selfId, peers, &PeerMetrics::messagesSent);
+    writeCounter(out, "sc_bytes_sent_total", "counter", "Payload bytes sent to the peer.", selfId, peers, &PeerMetrics::bytesSent);
+    writeCounter(out, "sc_send_failures_total", "counter", "Sends to the peer that failed.", selfId, peers, &PeerMetrics::sendFailures);
+    writeCounter(out, "sc_messages_received_total", "counter", "Messages from the peer handed to the application.", selfId, peers, &PeerMetrics::messagesReceived);
+    writeCounter(out, "sc_bytes_received_total", "counter", "Payload bytes from the peer handed to the application.", selfId, peers, &PeerMetrics::bytesReceived);
+    writeCounter(out, "sc_queue_depth", "gauge", "Messages from the peer buffered but not yet received.", selfId, peers, &PeerMetrics::queueDepth);
+    writeSummary(out, "sc_send_latency_ns", "Time spent in one send call to the peer.", selfId, peers, &PeerMetrics::sendLatency);
+    writeSummary(out, "sc_recv_wait_ns", "Wait from the start of a receive call to the peer's message arriving.", selfId, peers, &PeerMetrics::recvWait);
+    return out.str();
+}
@@ -0,0 +1,122 @@
+#include "PeerSendPool.h"
+#include "SpscRing.h"
+#include "CpuAffinity.h"
+#include <thread>
+
+namespace {
+// Polls before parking on a condition variable. Kept short so idle lanes of many
+// in-process parties do not burn CPU, but long enough to catch back-to-back rounds.
+constexpr int kSpinIterations = 256;
+} // namespace
+
+struct PeerSendPool::Lane {
+    struct Job {
+        zmq::message_t payload;
+        bool stop = false;
+    };
+
+    int peerId = 0;
+    SpscRing<Job, 8> jobs;
+    std::atomic<bool> parked{false};
+    std::mutex m;
+    std::condition_variable cv;
+    std::thread worker;
+
+    void push(Job&& job) {
+        while (!jobs.tryPush(std::move(job))) std::this_thread::yield();
+        // Pairs with the fence in runLane: either the lane sees the job or we see it parked
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lk(m);
+            cv.notify_one();
+        }
+    }
+};
+
+PeerSendPool::PeerSendPool(const std::vector<int>& peerIds, SendFn send, const std::vector<int>& cores)
+    : send_(std::move(send)) {
+    lanes_.reserve(peerIds.size());
+    for (int peerId : peerIds) {
+        auto lane = std::make_unique<Lane>();
+        lane->peerId = peerId;
+        lanes_.push_back(std::move(lane));
+    }
+    for (size_t k = 0; k < lanes_.size(); ++k) {
+        Lane* l = lanes_[k].get();
+        l->worker = std::thread([this, l]() { runLane(*l); });
+        if (!cores.empty()) cpu::pinThread(l->worker, cores[k % cores.size()]);
+    }
+}
+
+PeerSendPool::~PeerSendPool() {
+    for (auto& lane : lanes_) {
+        Lane::Job stop;
+        stop.stop = true;
+        lane->push(std::move(stop));
+    }
+    for (auto& lane : lanes_) {
+        if (lane->worker.joinable()) lane->worker.join();
+    }
+}
+
+bool PeerSendPool::sendToAll(zmq::message_t& payload) {
+    if (lanes_.empty()) return true;
+    done_.failed.store(false, std::memory_order_relaxed);
+    done_.remaining.store(static_cast<int>(lanes_.size()), std::memory_order_relaxed);
+
+    for (auto& lane : lanes_) {
+        Lane::Job job;
+        job.payload.copy(payload); // shares the buffer, no payload copy
+        lane->push(std::move(job));
+    }
+
+    for (int i = 0; i < kSpinIterations; ++i) {
+        if (done_.remaining.load(std::memory_order_acquire) == 0) {
+            return !done_.failed.load(std::memory_order_relaxed);
+        }
+    }
+    done_.waiterParked.store(true, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> lk(done_.m);
+        done_.cv.wait(lk, [this]() { return done_.remaining.load(std::memory_order_acquire) == 0; });
+    }
+    done_.waiterParked.store(false, std::memory_order_relaxed);
+    return !done_.failed.load(std::memory_order_relaxed);
+}
+
+void PeerSendPool::finishJob(bool ok) noexcept {
+    if (!ok) done_.failed.store(true, std::memory_order_relaxed);
+    if (done_.remaining.fetch_sub(1, std::memory_order_acq_rel) != 1) return;
+    // Last lane out wakes the caller if it already parked
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (done_.waiterParked.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lk(done_.m);
+        done_.cv.notify_one();
+    }
+}
+
+void PeerSendPool::runLane(Lane& lane) {
+    Lane::Job job;
+    while (true) {
+        bool got = false;
+        for (int i = 0; i < kSpinIterations && !got; ++i) got = lane.jobs.tryPop(job);
+        if (!got) {
+            lane.parked.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            std::unique_lock<std::mutex> lk(lane.m);
+            lane.cv.wait(lk, [&lane]() { return !lane.jobs.empty(); });
+            lane.parked.store(false, std::memory_order_relaxed);
+            continue;
+        }
+        if (job.stop) return;
+
+        bool ok = false;
+        try {
+            ok = send_(lane.peerId, std::move(job.payload));
+        } catch (...) {
+            ok = false;
+        }
+        finishJob(ok);
+    }
+}
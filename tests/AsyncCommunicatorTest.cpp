@@ -0,0 +1,72 @@
+#include <gtest/gtest.h>
+#include "AsyncCommunicator.h"
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST(AsyncCommunicatorTest, SendAndReceiveResolveFutures) {
+    const int base = 19000;
+    const int num_parties = 2;
+    AsyncCommunicator A{1, base, "127.0.0.1", num_parties};
+    AsyncCommunicator B{2, base, "127.0.0.1", num_parties};
+
+    // Post the receive before the message exists; it resolves when the loop sees it
+    auto pending = B.asyncRecvFrom(1);
+    ASSERT_TRUE(A.asyncSend(2, "hello").get());
+
+    ASSERT_EQ(pending.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(pending.get().to_string(), "hello");
+}
+
+TEST(AsyncCommunicatorTest, OverlapsRoundsAcrossParties) {
+    const int base = 19010;
+    const int N = 4;
+    const int rounds = 20;
+    std::vector<long long> totals(N + 1, 0);
+
+    std::vector<std::thread> parties;
+    for (int id = 1; id <= N; ++id) {
+        parties.emplace_back([&, id]() {
+            AsyncCommunicator me{id, base, "127.0.0.1", N};
+            std::vector<std::future<zmq::message_t>> incoming;
+            for (int r = 0; r < rounds; ++r) {
+                // Post this round's receives, send, then "compute" while messages fly
+                incoming.clear();
+                for (int peer = 1; peer <= N; ++peer) {
+                    if (peer != id) incoming.push_back(me.asyncRecvFrom(peer));
+                }
+                me.asyncSendToAll(std::to_string(id * 1000 + r));
+                long long local = id * 1000 + r;
+                for (auto& f : incoming) {
+                    if (f.wait_for(std::chrono::seconds(10)) != std::future_status::ready) return;
+                    local += std::stoll(f.get().to_string());
+                }
+                totals[id] += local;
+            }
+        });
+    }
+    for (auto& t : parties) t.join();
+
+    // Every party sums 1000*(1+..+N) + N*r for each round r
+    long long expected = 0;
+    for (int r = 0; r < rounds; ++r) expected += 1000LL * N * (N + 1) / 2 + static_cast<long long>(N) * r;
+    for (int id = 1; id <= N; ++id) {
+        EXPECT_EQ(totals[id], expected) << "party " << id;
+    }
+}
+
+TEST(AsyncCommunicatorTest, PublishReachesSubscriberFuture) {
+    const int base = 19020;
+    const int num_parties = 2;
+    AsyncCommunicator P{1, base, "127.0.0.1", num_parties, true};
+    AsyncCommunicator S{2, base, "127.0.0.1", num_parties, true};
+    // Let SUB connect before publishing (slow joiner)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    auto got = S.asyncSubRecvFrom(1);
+    ASSERT_TRUE(P.asyncPublish("bcast").get());
+    ASSERT_EQ(got.wait_for(std::chrono::seconds(5)), std::future_status::ready);
+    EXPECT_EQ(got.get().to_string(), "bcast");
+}
@@ -0,0 +1,121 @@
+#include <gtest/gtest.h>
+#include "BufferPool.h"
+#include <atomic>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+TEST(BufferPoolTest, SizeClassesArePowersOfTwo) {
+    EXPECT_EQ(BufferPool::classOf(0), 0u);
+    EXPECT_EQ(BufferPool::classOf(64), 0u);
+    EXPECT_EQ(BufferPool::classOf(65), 1u);
+    EXPECT_EQ(BufferPool::classOf(128), 1u);
+    EXPECT_EQ(BufferPool::classOf(4096), 6u);
+    EXPECT_EQ(BufferPool::classOf(size_t(4) << 20), BufferPool::kClasses - 1);
+    EXPECT_EQ(BufferPool::classOf((size_t(4) << 20) + 1), BufferPool::kClasses); // too large to pool
+    for (unsigned c = 0; c < BufferPool::kClasses; ++c) {
+        EXPECT_EQ(BufferPool::classOf(BufferPool::classBytes(c)), c);
+    }
+}
+
+TEST(BufferPoolTest, SteadyStateReusesBlocks) {
+    BufferPool pool;
+    for (int round = 0; round < 1000; ++round) {
+        void* a = pool.allocate(1000);
+        void* b = pool.allocate(100);
+        ASSERT_EQ(reinterpret_cast<uintptr_t>(a) % 16, 0u);
+        std::memset(a, 0xab, 1000); // the whole request is usable
+        std::memset(b, 0xcd, 100);
+        BufferPool::release(a);
+        BufferPool::release(b);
+    }
+    const auto s = pool.stats();
+    EXPECT_EQ(s.allocations, 2000u);
+    EXPECT_EQ(s.fresh, 2u);
+    EXPECT_EQ(s.outstanding, 2u); // cached by this thread
+
+    void* big = pool.allocate(size_t(8) << 20); // heap, not pooled
+    BufferPool::release(big);
+    BufferPool::release(nullptr);
+}
+
+// The sending thread allocates, another thread releases (as ZeroMQ's I/O thread does): blocks
+// must flow back through the shared lists rather than every send hitting the heap
+TEST(BufferPoolTest, BlocksReleasedOnAnotherThreadComeBack) {
+    BufferPool pool;
+    const int total = 20000;
+    std::vector<std::atomic<void*>> handoff(64);
+    for (auto& h : handoff) h.store(nullptr);
+    std::atomic<bool> done{false};
+
+    std::thread releaser([&]() {
+        int seen = 0;
+        while (seen < total) {
+            for (auto& h : handoff) {
+                if (void* p = h.exchange(nullptr)) {
+                    BufferPool::release(p);
+                    ++seen;
+                }
+            }
+        }
+        done = true;
+    });
+    for (int i = 0; i < total; ++i) {
+        void* p = pool.allocate(4096);
+        static_cast<char*>(p)[4095] = 1;
+        auto& slot = handoff[i % handoff.size()];
+        void* expected = nullptr;
+        while (!slot.compare_exchange_weak(expected, p)) {
+            expected = nullptr;
+            std::this_thread::yield();
+        }
+    }
+    releaser.join();
+    EXPECT_TRUE(done.load());
+    const auto s = pool.stats();
+    EXPECT_EQ(s.allocations, uint64_t(total));
+    EXPECT_LT(s.fresh, uint64_t(total) / 10);
+}
+
+// A buffer may outlive its pool, e.g. a message ZeroMQ frees after the Communicator is gone
+TEST(BufferPoolTest, BuffersOutliveThePool) {
+    void* late = nullptr;
+    PooledBuffer held;
+    {
+        BufferPool pool;
+        late = pool.allocate(300);
+        held = PooledBuffer(pool, 5000);
+        void* cached = pool.allocate(300);
+        BufferPool::release(cached);
+    }
+    std::memset(late, 1, 300);
+    std::memset(held.data(), 2, held.size());
+    std::thread([late]() { BufferPool::release(late); }).join();
+    EXPECT_EQ(held.size(), 5000u);
+}
+
+// A long-lived thread (like ZeroMQ's I/O threads) releasing blocks for many short-lived pools
+// hands each dead pool's cached blocks back rather than running out of cache slots
+TEST(BufferPoolTest, LongLivedThreadsDropCachesOfDestroyedPools) {
+    std::atomic<void*> handoff{nullptr};
+    std::atomic<int> released{0};
+    std::atomic<bool> stop{false};
+    std::thread releaser([&]() {
+        while (!stop) {
+            if (void* p = handoff.exchange(nullptr)) {
+                BufferPool::release(p);
+                ++released;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (int i = 0; i < 12; ++i) {
+        BufferPool pool;
+        handoff = pool.allocate(1000);
+        while (released.load() != i + 1) std::this_thread::yield();
+        EXPECT_EQ(pool.stats().outstanding, 1u) << "pool " << i << " lost its cache slot on the releaser";
+    }
+    stop = true;
+    releaser.join();
+}
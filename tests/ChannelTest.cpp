@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include "CommunicatorChannel.h"
+#include "netmp_channel.h"
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+static_assert(IsChannel<CommunicatorChannel>::value, "Communicator adapter is a channel");
+static_assert(IsChannel<NetIOMPChannel<3>>::value, "NetIOMP adapter is a channel");
+static_assert(IsChannel<AnyChannel>::value, "type-erased wrapper is a channel");
+static_assert(!IsChannel<int>::value, "int is not a channel");
+
+static uint64_t input(int id, size_t k) {
+    return static_cast<uint64_t>(id) * 1000003u + k;
+}
+
+// One protocol for every backend: party 1 broadcasts a length, then everyone exchanges that
+// many values with everyone and sums them.
+template <typename Ch>
+static std::vector<uint64_t> broadcastThenSum(Ch& ch) {
+    uint64_t len = 0;
+    if (ch.party() == 1) {
+        len = 100000; // several allToAll pieces
+        EXPECT_TRUE(ch.broadcast(&len, sizeof(len)));
+        ch.flush(0);
+    } else {
+        EXPECT_TRUE(ch.recv(1, &len, sizeof(len)));
+    }
+    std::vector<uint64_t> mine(len), all(len * ch.parties()), sum(len);
+    for (size_t k = 0; k < len; ++k) mine[k] = input(ch.party(), k);
+    EXPECT_TRUE(allToAll(ch, mine.data(), all.data(), len * sizeof(uint64_t)));
+    std::copy(mine.begin(), mine.end(), all.begin() + len * (ch.party() - 1));
+    for (int p = 0; p < ch.parties(); ++p) {
+        for (size_t k = 0; k < len; ++k) sum[k] += all[len * p + k];
+    }
+    return sum;
+}
+
+static std::vector<uint64_t> expectedSum(int n, size_t len) {
+    std::vector<uint64_t> sum(len, 0);
+    for (int id = 1; id <= n; ++id) {
+        for (size_t k = 0; k < len; ++k) sum[k] += input(id, k);
+    }
+    return sum;
+}
+
+static void runThreads(int n, const std::function<void(int)>& body) {
+    std::vector<std::thread> threads;
+    for (int id = 1; id <= n; ++id) threads.emplace_back(body, id);
+    for (auto& t : threads) t.join();
+}
+
+TEST(ChannelTest, SameProtocolRunsOverCommunicator) {
+    const int N = 3;
+    std::vector<std::vector<uint64_t>> results(N);
+    runThreads(N, [&](int id) {
+        Communicator comm(id, 15400, "127.0.0.1", N);
+        comm.setUpRouterDealer();
+        ASSERT_TRUE(comm.awaitMeshReady(10000));
+        CommunicatorChannel ch(comm, 10000);
+        results[id - 1] = broadcastThenSum(ch);
+    });
+    for (int i = 0; i < N; ++i) EXPECT_EQ(results[i], expectedSum(N, 100000)) << "party " << (i + 1);
+}
+
+TEST(ChannelTest, SameProtocolRunsOverNetIOMP) {
+    const int N = 3;
+    std::vector<std::vector<uint64_t>> results(N);
+    runThreads(N, [&](int id) {
+        NetIOMP<N> io(id, 42300);
+        NetIOMPChannel<N> ch(io);
+        results[id - 1] = broadcastThenSum(ch);
+    });
+    for (int i = 0; i < N; ++i) EXPECT_EQ(results[i], expectedSum(N, 100000)) << "party " << (i + 1);
+}
+
+TEST(ChannelTest, AnyChannelPicksTheBackendAtRunTime) {
+    const int N = 2;
+    std::vector<std::vector<uint64_t>> results(N);
+    runThreads(N, [&](int id) {
+        NetIOMP<N, ShmIO> io(id, 42350);
+        NetIOMPChannel<N, ShmIO> shm(io);
+        std::unique_ptr<AnyChannel> ch = AnyChannel::wrap(shm);
+        EXPECT_EQ(ch->party(), id);
+        EXPECT_EQ(ch->parties(), N);
+        results[id - 1] = broadcastThenSum(*ch);
+    });
+    for (int i = 0; i < N; ++i) EXPECT_EQ(results[i], expectedSum(N, 100000)) << "party " << (i + 1);
+}
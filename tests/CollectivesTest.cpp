@@ -0,0 +1,108 @@
+#include <gtest/gtest.h>
+#include "Collectives.h"
+#include "Communicator.h"
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const uint64_t kQ = 8380417;
+
+// Party id's input at index k
+static uint64_t input(int id, size_t k) {
+    return (static_cast<uint64_t>(id) * 7919u + k * 104729u) % kQ;
+}
+
+static std::vector<uint64_t> expectedSum(int n, size_t len) {
+    std::vector<uint64_t> sum(len, 0);
+    for (int id = 1; id <= n; ++id) {
+        for (size_t k = 0; k < len; ++k) sum[k] = (sum[k] + input(id, k)) % kQ;
+    }
+    return sum;
+}
+
+// Run body(id, collectives) for every party in its own thread (one Communicator each)
+static void runParties(int n, int base, const std::function<void(int, Collectives&)>& body) {
+    std::vector<std::thread> threads;
+    threads.reserve(n);
+    for (int i = 0; i < n; ++i) {
+        threads.emplace_back([&, i]() {
+            const int id = i + 1;
+            Communicator me(id, base, "127.0.0.1", n);
+            me.setUpRouterDealer();
+            Collectives coll(me, kQ);
+            body(id, coll);
+        });
+    }
+    for (auto& t : threads) t.join();
+}
+
+// 7 parties (not a power of two) and a root other than party 1
+TEST(CollectivesTest, BinomialBroadcastReachesEveryParty) {
+    const int N = 7;
+    const int root = 3;
+    const size_t len = 1000;
+    std::vector<std::vector<uint64_t>> results(N);
+    std::vector<uint8_t> ok(N, 0);
+
+    runParties(N, 15300, [&](int id, Collectives& coll) {
+        std::vector<uint64_t> data;
+        if (id == root) {
+            data.resize(len);
+            for (size_t k = 0; k < len; ++k) data[k] = input(root, k);
+        }
+        ok[id - 1] = coll.broadcast(data, root, 10000);
+        results[id - 1] = std::move(data);
+    });
+
+    std::vector<uint64_t> expected(len);
+    for (size_t k = 0; k < len; ++k) expected[k] = input(root, k);
+    for (int i = 0; i < N; ++i) {
+        EXPECT_TRUE(ok[i]) << "party " << (i + 1);
+        EXPECT_EQ(results[i], expected) << "party " << (i + 1);
+    }
+}
+
+TEST(CollectivesTest, BinomialReduceSumsAtRoot) {
+    const int N = 7;
+    const int root = 5;
+    const size_t len = 1000;
+    std::vector<uint64_t> atRoot;
+    std::vector<uint8_t> ok(N, 0);
+
+    runParties(N, 15320, [&](int id, Collectives& coll) {
+        std::vector<uint64_t> data(len);
+        for (size_t k = 0; k < len; ++k) data[k] = input(id, k);
+        ok[id - 1] = coll.reduce(data, root, 10000);
+        if (id == root) atRoot = std::move(data);
+    });
+
+    for (int i = 0; i < N; ++i) EXPECT_TRUE(ok[i]) << "party " << (i + 1);
+    EXPECT_EQ(atRoot, expectedSum(N, len));
+}
+
+// Lengths that do not divide evenly, including fewer values than parties (empty ring segments),
+// and several collectives back to back on the same sockets
+TEST(CollectivesTest, RingAllreduceSumsEverywhere) {
+    const int N = 6;
+    const std::vector<size_t> lengths = {4096, 1001, 3, 0};
+    std::vector<std::vector<std::vector<uint64_t>>> results(N);
+    std::vector<uint8_t> ok(N, 1);
+
+    runParties(N, 15340, [&](int id, Collectives& coll) {
+        for (size_t len : lengths) {
+            std::vector<uint64_t> data(len);
+            for (size_t k = 0; k < len; ++k) data[k] = input(id, k);
+            if (!coll.allreduce(data, 10000)) ok[id - 1] = 0;
+            results[id - 1].push_back(std::move(data));
+        }
+    });
+
+    for (int i = 0; i < N; ++i) {
+        EXPECT_TRUE(ok[i]) << "party " << (i + 1);
+        ASSERT_EQ(results[i].size(), lengths.size());
+        for (size_t j = 0; j < lengths.size(); ++j) {
+            EXPECT_EQ(results[i][j], expectedSum(N, lengths[j])) << "party " << (i + 1) << " len " << lengths[j];
+        }
+    }
+}
@@ -1,10 +1,15 @@
 #include <gtest/gtest.h>
 #include "Communicator.h"
+#include "MessageCursor.h"
+#include "FieldPacking.h"
 #include <thread>
 #include <chrono>
 #include <vector>
 #include <unordered_map>
 #include <unordered_set>
+#include <cstring>
+#include <ctime>
+#include <unistd.h>
 #define BASE_PORT 10000
 TEST(CommunicatorTest, ConstructorStoresValues) {
     Communicator c{42, 5000, "192.168.1.10"};
@@ -50,6 +55,889 @@ TEST(CommunicatorTest, DealerSendToTargetsSpecificPeer) {
     EXPECT_EQ(msg, "to-C");
 }
 
+TEST(CommunicatorTest, RouterReceiveMovesMessageAndReportsPeerId) {
+    const int base = 9910;
+    const int num_parties = 3;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    Communicator C{3, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    C.setUpRouterDealer();
+
+    const std::string big(256 * 1024, 'm');
+    ASSERT_TRUE(B.dealerSendTo(1, big));
+    ASSERT_TRUE(C.dealerSendTo(1, "from-C"));
+
+    // Message overload: payload frame is moved out, identity parsed as an int
+    int fromId = -1;
+    zmq::message_t msg;
+    ASSERT_TRUE(A.routerReceive(fromId, msg, 1000));
+    bool sawB = false, sawC = false;
+    auto check = [&](int from, const void* data, size_t size) {
+        const std::string got(static_cast<const char*>(data), size);
+        if (from == 2) sawB = (got == big);
+        if (from == 3) sawC = (got == "from-C");
+    };
+    check(fromId, msg.data(), msg.size());
+
+    // View overload: callback sees the frame in place
+    ASSERT_TRUE(A.routerReceiveView(check, 1000));
+    EXPECT_TRUE(sawB);
+    EXPECT_TRUE(sawC);
+}
+
+// A DEALER that is not a party keeps its own routing id, so the ROUTER can reply to it
+TEST(CommunicatorTest, RouterReceiveKeepsNonPartyIdentities) {
+    const int base = 10260;
+    Communicator A{1, base, "127.0.0.1", 2};
+    A.setUpRouter();
+    zmq::context_t ctx;
+    for (const std::string name : {"client-x", "007"}) {
+        zmq::socket_t client(ctx, zmq::socket_type::dealer);
+        client.set(zmq::sockopt::routing_id, name);
+        client.set(zmq::sockopt::linger, 0);
+        client.connect("tcp://127.0.0.1:" + std::to_string(base + 1));
+        ASSERT_TRUE(client.send(zmq::message_t("hi", 2), zmq::send_flags::none));
+
+        std::string from, payload;
+        ASSERT_TRUE(A.routerReceive(from, payload, 1000));
+        EXPECT_EQ(from, name);
+        EXPECT_EQ(payload, "hi");
+        ASSERT_TRUE(A.routerSend(from, "reply"));
+        zmq::message_t got;
+        ASSERT_TRUE(client.recv(got, zmq::recv_flags::none));
+        EXPECT_EQ(got.to_string(), "reply");
+    }
+}
+
+TEST(CommunicatorTest, SubReceiveReportsPublisherId) {
+    const int base = 9920;
+    const int num_parties = 2;
+    Communicator P{1, base, "127.0.0.1", num_parties};
+    Communicator S{2, base, "127.0.0.1", num_parties};
+    P.setUpPublisher();
+    S.setUpSubscribers();
+    // Let SUB connect before publishing (slow joiner)
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    ASSERT_TRUE(P.pubBroadcast("hello"));
+    ASSERT_TRUE(P.pubBroadcast("again"));
+
+    std::string fromStr, payload;
+    ASSERT_TRUE(S.subReceive(fromStr, payload, 1000));
+    EXPECT_EQ(fromStr, "1");
+    EXPECT_EQ(payload, "hello");
+
+    int fromId = -1;
+    zmq::message_t msg;
+    ASSERT_TRUE(S.subReceive(fromId, msg, 1000));
+    EXPECT_EQ(fromId, 1);
+    EXPECT_EQ(msg.to_string(), "again");
+}
+
+TEST(CommunicatorTest, RouterReceiveFromAllGathersAndReportsMissing) {
+    const int base = 9930;
+    const int num_parties = 4;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    Communicator C{3, base, "127.0.0.1", num_parties};
+    Communicator D{4, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    C.setUpRouterDealer();
+    D.setUpRouterDealer();
+
+    // Round 0: B and C deliver, B also sends its round-1 value early; D stays silent
+    ASSERT_TRUE(B.dealerSendTo(1, "b0"));
+    ASSERT_TRUE(B.dealerSendTo(1, "b1"));
+    ASSERT_TRUE(C.dealerSendTo(1, "c0"));
+
+    std::vector<zmq::message_t> payloads;
+    std::vector<int> missing;
+    EXPECT_FALSE(A.routerReceiveFromAll(payloads, missing, 300));
+    ASSERT_EQ(payloads.size(), static_cast<size_t>(num_parties + 1));
+    EXPECT_EQ(payloads[2].to_string(), "b0");
+    EXPECT_EQ(payloads[3].to_string(), "c0");
+    ASSERT_EQ(missing.size(), 1u);
+    EXPECT_EQ(missing[0], 4);
+
+    // Round 1: B's early message was kept; C and D deliver now
+    ASSERT_TRUE(C.dealerSendTo(1, "c1"));
+    ASSERT_TRUE(D.dealerSendTo(1, "d1"));
+    EXPECT_TRUE(A.routerReceiveFromAll(payloads, missing, 1000));
+    EXPECT_TRUE(missing.empty());
+    EXPECT_EQ(payloads[2].to_string(), "b1");
+    EXPECT_EQ(payloads[3].to_string(), "c1");
+    EXPECT_EQ(payloads[4].to_string(), "d1");
+}
+
+TEST(CommunicatorTest, RouterReceiveFromKeepsOtherPeersMessages) {
+    const int base = 9940;
+    const int num_parties = 3;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    Communicator C{3, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    C.setUpRouterDealer();
+
+    ASSERT_TRUE(B.dealerSendTo(1, "from-B"));
+    // Wait for B's message to be queued at A before C sends, so it is first in line
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(C.dealerSendTo(1, "from-C"));
+
+    zmq::message_t msg;
+    ASSERT_TRUE(A.routerReceiveFrom(3, msg, 1000));
+    EXPECT_EQ(msg.to_string(), "from-C");
+
+    // B's message was parked, not lost
+    std::string from, payload;
+    ASSERT_TRUE(A.routerReceive(from, payload, 0));
+    EXPECT_EQ(from, "2");
+    EXPECT_EQ(payload, "from-B");
+}
+
+TEST(CommunicatorTest, RoundTaggedMessagesAreReassembledByRound) {
+    const int base = 9950;
+    const int num_parties = 3;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    Communicator C{3, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    C.setUpRouterDealer();
+
+    // B races ahead: its round 1 message goes out before C's round 0 message
+    ASSERT_TRUE(B.dealerSendRound(1, 0, "b-r0"));
+    ASSERT_TRUE(B.dealerSendRound(1, 1, "b-r1"));
+    ASSERT_TRUE(C.dealerSendTo(1, "untagged"));
+    ASSERT_TRUE(C.dealerSendRound(1, 0, "c-r0"));
+    ASSERT_TRUE(C.dealerSendRound(1, 1, "c-r1"));
+
+    // Round 1 asked for first: round 0 traffic is buffered, not lost or mixed up
+    zmq::message_t msg;
+    ASSERT_TRUE(A.routerReceiveRound(2, 1, msg, 1000));
+    EXPECT_EQ(msg.to_string(), "b-r1");
+
+    std::vector<zmq::message_t> round0;
+    std::vector<int> missing;
+    ASSERT_TRUE(A.routerReceiveRoundFromAll(0, round0, missing, 1000));
+    EXPECT_EQ(round0[2].to_string(), "b-r0");
+    EXPECT_EQ(round0[3].to_string(), "c-r0");
+
+    ASSERT_TRUE(A.routerReceiveRound(3, 1, msg, 1000));
+    EXPECT_EQ(msg.to_string(), "c-r1");
+
+    // Untagged traffic travels alongside without being consumed by round receives
+    std::string from, payload;
+    ASSERT_TRUE(A.routerReceive(from, payload, 1000));
+    EXPECT_EQ(from, "3");
+    EXPECT_EQ(payload, "untagged");
+}
+
+TEST(CommunicatorTest, RoundTaggedMessagesFromOtherSessionsAreDropped) {
+    const int base = 9960;
+    const int num_parties = 2;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    A.setSession(7);
+
+    B.setSession(6);
+    ASSERT_TRUE(B.dealerSendRound(1, 0, "stale"));
+    B.setSession(7);
+    ASSERT_TRUE(B.dealerSendRound(1, 0, "fresh"));
+
+    zmq::message_t msg;
+    ASSERT_TRUE(A.routerReceiveRound(2, 0, msg, 1000));
+    EXPECT_EQ(msg.to_string(), "fresh");
+    EXPECT_FALSE(A.routerReceiveRound(2, 0, msg, 100));
+}
+
+TEST(CommunicatorTest, PollDispatchesRouterSubAndDealerTrafficFromOneThread) {
+    const int base = 9970;
+    const int num_parties = 3;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    Communicator C{3, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    A.setUpSubscribers();
+    B.setUpRouterDealer();
+    C.setUpPublisher();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Point-to-point to A, a broadcast A subscribes to, and a ROUTER reply back to A's DEALER
+    ASSERT_TRUE(B.dealerSendTo(1, "p2p"));
+    ASSERT_TRUE(C.pubBroadcast("bcast"));
+    std::string from, msg;
+    ASSERT_TRUE(A.dealerSendTo(2, "ping"));
+    ASSERT_TRUE(B.routerReceive(from, msg, 1000));
+    ASSERT_TRUE(B.routerSend(from, "pong"));
+
+    std::string gotRouter, gotSub, gotReply;
+    int routerFrom = 0, subFrom = 0, replyFrom = 0;
+    Communicator::PollHandlers handlers;
+    handlers.onRouter = [&](int id, zmq::message_t& m) { routerFrom = id; gotRouter = m.to_string(); };
+    handlers.onSub = [&](int id, zmq::message_t& m) { subFrom = id; gotSub = m.to_string(); };
+    handlers.onDealerReply = [&](int id, zmq::message_t& m) { replyFrom = id; gotReply = m.to_string(); };
+
+    int total = 0;
+    for (int i = 0; i < 10 && total < 3; ++i) total += A.poll(handlers, 500);
+    EXPECT_EQ(total, 3);
+    EXPECT_EQ(routerFrom, 2);
+    EXPECT_EQ(gotRouter, "p2p");
+    EXPECT_EQ(subFrom, 3);
+    EXPECT_EQ(gotSub, "bcast");
+    EXPECT_EQ(replyFrom, 2);
+    EXPECT_EQ(gotReply, "pong");
+
+    // Nothing left: poll times out without dispatching
+    EXPECT_EQ(A.poll(handlers, 50), 0);
+    // No handler for any socket: returns at once even without a timeout
+    EXPECT_EQ(A.poll(Communicator::PollHandlers{}, -1), 0);
+}
+
+// A poll handler may itself receive; the message it was given is already off the queue
+TEST(CommunicatorTest, PollHandlersMayReceive) {
+    const int base = 10290;
+    Communicator A{1, base, "127.0.0.1", 3};
+    Communicator B{2, base, "127.0.0.1", 3};
+    Communicator C{3, base, "127.0.0.1", 3};
+    for (Communicator* c : {&A, &B, &C}) c->setUpRouterDealer();
+    A.setFlowBudget(64);
+    B.setFlowBudget(64);
+    C.setFlowBudget(64);
+
+    ASSERT_TRUE(B.dealerSendTo(1, std::string(40, 'b')));
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    ASSERT_TRUE(C.dealerSendTo(1, std::string(40, 'c')));
+    zmq::message_t msg;
+    ASSERT_TRUE(A.routerReceiveFrom(3, msg, 1000)); // parks B's message
+    ASSERT_TRUE(C.waitForCredit(1, 64, 1000));
+    ASSERT_TRUE(C.dealerSendTo(1, std::string(40, 'd')));
+
+    std::vector<std::string> seen;
+    Communicator::PollHandlers handlers;
+    handlers.onRouter = [&](int from, zmq::message_t& m) {
+        seen.push_back(std::to_string(from) + m.to_string().substr(0, 1));
+        zmq::message_t inner;
+        if (from == 2 && A.routerReceiveFrom(3, inner, 1000)) seen.push_back("3" + inner.to_string().substr(0, 1));
+    };
+    EXPECT_EQ(A.poll(handlers, 1000), 1);
+    EXPECT_EQ(seen, (std::vector<std::string>{"2b", "3d"}));
+    EXPECT_EQ(A.poll(handlers, 50), 0);
+    // Each sender got its own grant back
+    EXPECT_TRUE(B.waitForCredit(1, 64, 1000));
+    EXPECT_TRUE(C.waitForCredit(1, 64, 1000));
+}
+
+TEST(CommunicatorTest, QueuedSmallMessagesArriveAsOneCoalescedMessage) {
+    const int base = 9980;
+    const int num_parties = 2;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+
+    const int count = 1000;
+    for (uint64_t v = 0; v < static_cast<uint64_t>(count); ++v) {
+        ASSERT_TRUE(A.queue(2, &v, sizeof(v)));
+    }
+    ASSERT_TRUE(A.flushAll());
+
+    int from = 0;
+    zmq::message_t msg;
+    ASSERT_TRUE(B.routerReceive(from, msg, 1000));
+    EXPECT_EQ(from, 1);
+
+    MessageCursor cursor(msg);
+    const void* rec = nullptr;
+    size_t len = 0;
+    uint64_t expected = 0;
+    while (cursor.next(rec, len)) {
+        ASSERT_EQ(len, sizeof(uint64_t));
+        uint64_t v = 0;
+        std::memcpy(&v, rec, sizeof(v));
+        EXPECT_EQ(v, expected);
+        ++expected;
+    }
+    EXPECT_TRUE(cursor.atEnd());
+    EXPECT_EQ(expected, static_cast<uint64_t>(count));
+
+    // Only one wire message was sent for all records
+    EXPECT_FALSE(B.routerReceive(from, msg, 50));
+}
+
+TEST(CommunicatorTest, CoalescingBufferFlushesAtThreshold) {
+    const int base = 9990;
+    const int num_parties = 2;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    A.setCoalesceThreshold(64);
+
+    const std::string rec(28, 'r'); // 4-byte prefix + 28 = 32 bytes per record
+    ASSERT_TRUE(A.queue(2, rec));
+    ASSERT_TRUE(A.queue(2, rec)); // reaches 64 bytes: sent without an explicit flush
+
+    std::string from, msg;
+    ASSERT_TRUE(B.routerReceive(from, msg, 1000));
+    EXPECT_EQ(msg.size(), 64u);
+}
+
+// A flush that cannot send (here: no credit) keeps the records for the next flush
+TEST(CommunicatorTest, FailedFlushKeepsQueuedRecords) {
+    const int base = 10250;
+    Communicator A{1, base, "127.0.0.1", 2};
+    Communicator B{2, base, "127.0.0.1", 2};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    A.setFlowBudget(1024);
+    B.setFlowBudget(1024);
+    A.setCreditTimeout(20);
+
+    ASSERT_TRUE(A.dealerSendTo(2, std::string(1024, 'x')));
+    ASSERT_TRUE(A.queue(2, "kept"));
+    EXPECT_FALSE(A.flushAll());
+
+    zmq::message_t msg;
+    ASSERT_TRUE(B.routerReceiveFrom(1, msg, 1000));
+    ASSERT_TRUE(A.waitForCredit(2, 1024, 1000));
+    ASSERT_TRUE(A.flushAll());
+    ASSERT_TRUE(B.routerReceiveFrom(1, msg, 1000));
+    MessageCursor cursor(msg);
+    const void* rec = nullptr;
+    size_t len = 0;
+    ASSERT_TRUE(cursor.next(rec, len));
+    EXPECT_EQ(std::string(static_cast<const char*>(rec), len), "kept");
+    EXPECT_TRUE(cursor.atEnd());
+}
+
+TEST(CommunicatorTest, SendVecRoundTripsUint64Shares) {
+    const int base = 10100;
+    const int num_parties = 2;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+
+    std::vector<uint64_t> shares(100000);
+    for (size_t i = 0; i < shares.size(); ++i) shares[i] = (i * 0x9E3779B97F4A7C15ull) ^ (i << 40);
+    ASSERT_TRUE(A.sendVec(2, shares));
+    ASSERT_TRUE(A.sendVec(2, std::vector<uint64_t>{})); // empty vectors are valid messages
+
+    std::vector<uint64_t> got;
+    ASSERT_TRUE(B.recvVec(1, got, 1000));
+    EXPECT_EQ(got, shares);
+    ASSERT_TRUE(B.recvVec(1, got, 1000));
+    EXPECT_TRUE(got.empty());
+
+    // A payload that is not a whole number of uint64 values is rejected
+    ASSERT_TRUE(A.dealerSendTo(2, "odd"));
+    EXPECT_FALSE(B.recvVec(1, got, 1000));
+}
+
+TEST(CommunicatorTest, SendPackedRoundTripsFieldElements) {
+    const int base = 10110;
+    const int num_parties = 2;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+
+    const uint64_t Q = 8380417;
+    const unsigned bits = fieldpack::bitsFor(Q);
+    std::vector<uint64_t> shares(100001);
+    for (size_t i = 0; i < shares.size(); ++i) shares[i] = (i * 0x9E3779B97F4A7C15ull) % Q;
+    ASSERT_TRUE(A.sendPacked(2, shares, bits));
+
+    std::vector<uint64_t> got;
+    ASSERT_TRUE(B.recvPacked(1, got, bits, 1000));
+    EXPECT_EQ(got, shares);
+
+    // A count header that does not match the payload length is rejected
+    ASSERT_TRUE(A.sendVec(2, std::vector<uint64_t>{1000, 0}));
+    EXPECT_FALSE(B.recvPacked(1, got, bits, 1000));
+}
+
+// Exchange one DEALER message each way plus one PUB/SUB broadcast between A and B
+static void exchangeOverTransport(Communicator& A, Communicator& B) {
+    A.setUpRouter();
+    B.setUpRouter();
+    A.setUpPublisher();
+    B.setUpPublisher();
+    A.setUpPerPeerDealers();
+    B.setUpPerPeerDealers();
+    A.setUpSubscribers();
+    B.setUpSubscribers();
+
+    ASSERT_TRUE(A.dealerSendTo(2, "a->b"));
+    ASSERT_TRUE(B.dealerSendTo(1, "b->a"));
+    zmq::message_t msg;
+    ASSERT_TRUE(B.routerReceiveFrom(1, msg, 1000));
+    EXPECT_EQ(msg.to_string(), "a->b");
+    ASSERT_TRUE(A.routerReceiveFrom(2, msg, 1000));
+    EXPECT_EQ(msg.to_string(), "b->a");
+
+    // PUB/SUB drops messages sent before the subscription lands; publish until one arrives
+    int from = -1;
+    bool got = false;
+    for (int attempt = 0; attempt < 50 && !got; ++attempt) {
+        A.pubBroadcast("bcast");
+        got = B.subReceive(from, msg, 20);
+    }
+    ASSERT_TRUE(got);
+    EXPECT_EQ(from, 1);
+    EXPECT_EQ(msg.to_string(), "bcast");
+}
+
+TEST(CommunicatorTest, InprocTransportBetweenInProcessParties) {
+    Communicator A{1, 10120, "127.0.0.1", 2};
+    Communicator B{2, 10120, "127.0.0.1", 2};
+    A.setTransport(Communicator::Transport::Inproc);
+    B.setTransport(Communicator::Transport::Inproc);
+    exchangeOverTransport(A, B);
+    EXPECT_EQ(A.dealerEndpoint(2), "inproc://sc-10122");
+}
+
+TEST(CommunicatorTest, IpcTransportBetweenSameHostParties) {
+    Communicator A{1, 10130, "127.0.0.1", 2};
+    Communicator B{2, 10130, "127.0.0.1", 2};
+    A.setTransport(Communicator::Transport::Ipc);
+    B.setTransport(Communicator::Transport::Ipc);
+    exchangeOverTransport(A, B);
+    EXPECT_EQ(A.dealerEndpoint(2), "ipc:///tmp/sc-" + std::to_string(getuid()) + "-10132.ipc");
+}
+
+TEST(CommunicatorTest, AutoTransportPicksInprocForInProcessPeers) {
+    Communicator A{1, 10140, "127.0.0.1", 2};
+    Communicator B{2, 10140, "127.0.0.1", 2};
+    A.setTransport(Communicator::Transport::Auto);
+    B.setTransport(Communicator::Transport::Auto);
+    exchangeOverTransport(A, B);
+    // Both ROUTERs were bound before the dealers connected, so both sides found each other in-process
+    EXPECT_EQ(A.dealerEndpoint(2), "inproc://sc-10142");
+    EXPECT_EQ(B.dealerEndpoint(1), "inproc://sc-10141");
+
+    // A TCP-only party on its own context still reaches an Auto party
+    Communicator C{3, 10140, "127.0.0.1", 3};
+    C.setUpPerPeerDealers();
+    EXPECT_EQ(C.dealerEndpoint(2), "tcp://127.0.0.1:10142");
+    ASSERT_TRUE(C.dealerSendTo(2, "tcp"));
+    int from = -1;
+    zmq::message_t msg;
+    ASSERT_TRUE(B.routerReceive(from, msg, 1000));
+    EXPECT_EQ(from, 3);
+    EXPECT_EQ(msg.to_string(), "tcp");
+}
+
+// A peer that only bound tcp, and that no Auto party registered, is reached over tcp
+TEST(CommunicatorTest, AutoTransportFallsBackToTcpForUnregisteredPeers) {
+    Communicator T{2, 10270, "127.0.0.1", 2};
+    T.setUpRouter();
+    Communicator X{1, 10270, "127.0.0.1", 2};
+    X.setTransport(Communicator::Transport::Auto);
+    X.setUpPerPeerDealers();
+    EXPECT_EQ(X.dealerEndpoint(2), "tcp://127.0.0.1:10272");
+    ASSERT_TRUE(X.dealerSendTo(2, "over-tcp"));
+    int from = -1;
+    zmq::message_t msg;
+    ASSERT_TRUE(T.routerReceive(from, msg, 1000));
+    EXPECT_EQ(from, 1);
+    EXPECT_EQ(msg.to_string(), "over-tcp");
+}
+
+TEST(CommunicatorTest, StreamSendDeliversChunksInOrder) {
+    const int base = 10150;
+    Communicator A{1, base, "127.0.0.1", 2};
+    Communicator B{2, base, "127.0.0.1", 2};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    A.setChunkSize(64 * 1024);
+
+    std::string payload(1024 * 1024 + 123, '\0');
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>(i * 131);
+    ASSERT_TRUE(A.streamSend(2, 7, payload));
+    ASSERT_TRUE(A.streamSend(2, 8, std::string())); // empty stream: one empty chunk
+
+    std::string rebuilt;
+    uint32_t expectedIndex = 0;
+    ASSERT_TRUE(B.streamReceive(1, 7, [&](const Communicator::StreamChunk& c) {
+        EXPECT_EQ(c.index, expectedIndex++);
+        EXPECT_EQ(c.count, 17u);
+        EXPECT_EQ(c.offset, rebuilt.size());
+        EXPECT_EQ(c.total, payload.size());
+        rebuilt.append(static_cast<const char*>(c.data.data()), c.data.size());
+    }, 1000));
+    EXPECT_EQ(expectedIndex, 17u);
+    EXPECT_EQ(rebuilt, payload);
+
+    zmq::message_t empty;
+    ASSERT_TRUE(B.streamReceive(1, 8, empty, 1000));
+    EXPECT_EQ(empty.size(), 0u);
+}
+
+// 1 -> 2 -> 3: party 2 forwards each chunk on arrival and also reassembles its own copy
+TEST(CommunicatorTest, StreamRelayForwardsChunksAsTheyArrive) {
+    const int base = 10160;
+    Communicator A{1, base, "127.0.0.1", 3};
+    Communicator B{2, base, "127.0.0.1", 3};
+    Communicator C{3, base, "127.0.0.1", 3};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    C.setUpRouterDealer();
+    A.setChunkSize(32 * 1024);
+
+    std::string payload(512 * 1024, 'r');
+    ASSERT_TRUE(A.streamSend(2, 1, payload));
+
+    size_t relayed = 0;
+    ASSERT_TRUE(B.streamRelay(1, 1, {3}, [&](const Communicator::StreamChunk& c) { relayed += c.data.size(); }, 1000));
+    EXPECT_EQ(relayed, payload.size());
+
+    zmq::message_t got;
+    ASSERT_TRUE(C.streamReceive(2, 1, got, 1000));
+    EXPECT_EQ(got.to_string(), payload);
+}
+
+TEST(CommunicatorTest, FlowControlReportsBackpressureUntilReceiverConsumes) {
+    const int base = 10170;
+    Communicator A{1, base, "127.0.0.1", 2};
+    Communicator B{2, base, "127.0.0.1", 2};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    const size_t budget = 64 * 1024;
+    A.setFlowBudget(budget);
+    B.setFlowBudget(budget);
+    A.setCreditTimeout(50);
+
+    const std::string block(16 * 1024, 'f');
+    for (int i = 0; i < 4; ++i) {
+        ASSERT_EQ(A.trySendTo(2, zmq::message_t(block.data(), block.size())), Communicator::SendResult::Ok);
+    }
+    EXPECT_EQ(A.availableCredit(2), 0);
+
+    // Out of credit: nothing is sent or queued, and the payload stays with the caller
+    zmq::message_t extra(block.data(), block.size());
+    EXPECT_EQ(A.trySendTo(2, std::move(extra)), Communicator::SendResult::WouldBlock);
+    EXPECT_EQ(extra.size(), block.size());
+    EXPECT_FALSE(A.dealerSendTo(2, block)); // waits the 50 ms credit timeout, then fails
+    EXPECT_FALSE(A.waitForCredit(2, block.size(), 50));
+
+    // Consuming half the budget sends one grant back
+    zmq::message_t got;
+    ASSERT_TRUE(B.routerReceiveFrom(1, got, 1000));
+    ASSERT_TRUE(B.routerReceiveFrom(1, got, 1000));
+    ASSERT_TRUE(A.waitForCredit(2, block.size(), 1000));
+    EXPECT_EQ(A.availableCredit(2), static_cast<int64_t>(budget / 2));
+    EXPECT_EQ(A.trySendTo(2, std::move(extra)), Communicator::SendResult::Ok);
+
+    // Everything that was accepted arrives; nothing was dropped
+    for (int i = 0; i < 3; ++i) ASSERT_TRUE(B.routerReceiveFrom(1, got, 1000));
+    EXPECT_FALSE(B.routerReceiveFrom(1, got, 50));
+}
+
+// Credit comes back for messages a poll handler moves out and for round frames dropped as stale,
+// so neither leaves the sender waiting for good
+TEST(CommunicatorTest, FlowControlReturnsCreditForMovedAndStaleMessages) {
+    const int base = 10240;
+    Communicator A{1, base, "127.0.0.1", 2};
+    Communicator B{2, base, "127.0.0.1", 2};
+    A.setUpRouterDealer();
+    B.setUpRouterDealer();
+    const size_t budget = 64 * 1024;
+    A.setFlowBudget(budget);
+    B.setFlowBudget(budget);
+    A.setCreditTimeout(50);
+
+    const std::string block(budget / 2, 'm');
+    ASSERT_TRUE(A.dealerSendTo(2, block));
+    ASSERT_TRUE(A.dealerSendTo(2, block));
+    EXPECT_EQ(A.availableCredit(2), 0);
+    zmq::message_t kept;
+    Communicator::PollHandlers handlers;
+    handlers.onRouter = [&](int, zmq::message_t& m) { kept = std::move(m); };
+    int total = 0;
+    for (int i = 0; i < 10 && total < 2; ++i) total += B.poll(handlers, 500);
+    ASSERT_EQ(total, 2);
+    EXPECT_EQ(kept.size(), block.size());
+    ASSERT_TRUE(A.waitForCredit(2, budget, 1000));
+
+    // B still runs session 0, so both frames are dropped unread
+    A.setSession(6);
+    ASSERT_TRUE(A.dealerSendRound(2, 0, block));
+    ASSERT_TRUE(A.dealerSendRound(2, 0, block));
+    EXPECT_EQ(A.availableCredit(2), 0);
+    zmq::message_t msg;
+    EXPECT_FALSE(B.routerReceiveRound(1, 0, msg, 100));
+    ASSERT_TRUE(A.waitForCredit(2, budget, 1000));
+    EXPECT_EQ(A.availableCredit(2), static_cast<int64_t>(budget));
+}
+
+// A stream far larger than the budget still completes, paced by the receiver's grants
+TEST(CommunicatorTest, FlowControlPacesLargeStream) {
+    const int base = 10180;
+    const size_t budget = 256 * 1024;
+    std::string payload(8 * 1024 * 1024, '\0');
+    for (size_t i = 0; i < payload.size(); ++i) payload[i] = static_cast<char>(i * 7);
+
+    std::string received;
+    std::thread rx([&]() {
+        Communicator B{2, base, "127.0.0.1", 2};
+        B.setUpRouterDealer();
+        B.setFlowBudget(budget);
+        zmq::message_t msg;
+        if (B.streamReceive(1, 1, msg, 5000)) received = msg.to_string();
+    });
+
+    Communicator A{1, base, "127.0.0.1", 2};
+    A.setUpRouterDealer();
+    A.setFlowBudget(budget);
+    A.setCreditTimeout(5000);
+    A.setChunkSize(64 * 1024);
+    EXPECT_TRUE(A.streamSend(2, 1, payload));
+    rx.join();
+    EXPECT_EQ(received, payload);
+}
+
+// One ROUTER per party: untagged fan-out + gather, then a round-tagged exchange, across all pairs
+TEST(CommunicatorTest, MeshModeConnectsAllPairsWithOneSocketPerParty) {
+    const int N = 6;
+    const int base = 10190;
+    std::vector<uint8_t> ok(N, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < N; ++i) {
+        threads.emplace_back([&, i]() {
+            const int id = i + 1;
+            Communicator me(id, base, "127.0.0.1", N);
+            me.setUpMesh();
+            if (!me.isMesh()) return;
+
+            if (!me.dealerSendToAllParallel(std::to_string(id))) return;
+            std::vector<zmq::message_t> got;
+            std::vector<int> missing;
+            if (!me.routerReceiveFromAll(got, missing, 5000)) return;
+            for (int peer = 1; peer <= N; ++peer) {
+                if (peer != id && got[peer].to_string() != std::to_string(peer)) return;
+            }
+
+            for (int peer = 1; peer <= N; ++peer) {
+                if (peer != id && !me.dealerSendRound(peer, 1, std::to_string(id * 100 + peer))) return;
+            }
+            for (int peer = 1; peer <= N; ++peer) {
+                if (peer == id) continue;
+                zmq::message_t msg;
+                if (!me.routerReceiveRound(peer, 1, msg, 5000)) return;
+                if (msg.to_string() != std::to_string(peer * 100 + id)) return;
+            }
+            ok[i] = 1;
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (int i = 0; i < N; ++i) EXPECT_TRUE(ok[i]) << "party " << (i + 1);
+}
+
+TEST(CommunicatorTest, AwaitMeshReadyHandshakesRouterAndPubSub) {
+    const int N = 5;
+    const int base = 10200;
+    std::vector<uint8_t> ok(N, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < N; ++i) {
+        threads.emplace_back([&, i]() {
+            const int id = i + 1;
+            Communicator me(id, base, "127.0.0.1", N);
+            me.setUpRouterDealer();
+            me.setUpPublisher();
+            me.setUpSubscribers();
+            if (!me.awaitMeshReady(5000)) return;
+
+            // No settle sleep: the very first publish must reach every subscriber
+            if (!me.pubBroadcast("pub" + std::to_string(id))) return;
+            if (!me.dealerSendToAll("p2p" + std::to_string(id))) return;
+            std::vector<uint8_t> seenSub(N + 1, 0);
+            for (int k = 0; k < N - 1; ++k) {
+                int from = 0;
+                zmq::message_t msg;
+                if (!me.subReceive(from, msg, 2000)) return;
+                if (from < 1 || from > N || msg.to_string() != "pub" + std::to_string(from)) return;
+                seenSub[from] = 1;
+            }
+            std::vector<zmq::message_t> got;
+            std::vector<int> missing;
+            if (!me.routerReceiveFromAll(got, missing, 2000)) return;
+            for (int peer = 1; peer <= N; ++peer) {
+                if (peer == id) continue;
+                if (!seenSub[peer] || got[peer].to_string() != "p2p" + std::to_string(peer)) return;
+            }
+            ok[i] = 1;
+        });
+    }
+    for (auto& t : threads) t.join();
+    for (int i = 0; i < N; ++i) EXPECT_TRUE(ok[i]) << "party " << (i + 1);
+}
+
+// Data parked during the handshake must not turn the readiness wait for a late peer into a spin
+TEST(CommunicatorTest, AwaitMeshReadySleepsWhileEarlyDataIsParked) {
+    const int base = 10280;
+    Communicator A{1, base, "127.0.0.1", 3};
+    Communicator B{2, base, "127.0.0.1", 3};
+    Communicator C{3, base, "127.0.0.1", 3};
+    for (Communicator* c : {&A, &B, &C}) c->setUpRouterDealer();
+
+    bool bReady = false, cReady = false;
+    std::thread early([&]() {
+        if (B.dealerSendTo(1, "early")) bReady = B.awaitMeshReady(5000); // data before its Hello
+    });
+    std::thread late([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(300));
+        cReady = C.awaitMeshReady(5000);
+    });
+    timespec cpu0{}, cpu1{};
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu0);
+    const bool aReady = A.awaitMeshReady(5000);
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu1);
+    early.join();
+    late.join();
+    ASSERT_TRUE(aReady && bReady && cReady);
+
+    const double cpuMs = (cpu1.tv_sec - cpu0.tv_sec) * 1e3 + (cpu1.tv_nsec - cpu0.tv_nsec) / 1e6;
+    EXPECT_LT(cpuMs, 150.0); // ~300 ms of waiting on C, mostly asleep
+    zmq::message_t msg;
+    ASSERT_TRUE(A.routerReceiveFrom(2, msg, 0));
+    EXPECT_EQ(msg.to_string(), "early");
+}
+
+TEST(CommunicatorTest, MetricsCountPerPeerTrafficAndQueueDepth) {
+    const int base = 10210;
+    const int num_parties = 3;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    Communicator C{3, base, "127.0.0.1", num_parties};
+    for (Communicator* c : {&A, &B, &C}) c->setUpRouter();
+    for (Communicator* c : {&A, &B, &C}) c->setUpPerPeerDealers();
+
+    ASSERT_TRUE(B.dealerSendRound(1, 1, std::string(100, 'a')));
+    ASSERT_TRUE(B.dealerSendRound(1, 2, std::string(50, 'b')));
+    ASSERT_TRUE(C.dealerSendTo(1, "hi"));
+    EXPECT_FALSE(B.dealerSendTo(9, "nobody")); // no such peer
+
+    // Round 2 is asked for first, so B's round 1 arrives and waits in the reorder buffer
+    zmq::message_t msg;
+    ASSERT_TRUE(A.routerReceiveRound(2, 2, msg, 1000));
+    ASSERT_TRUE(A.routerReceiveFrom(3, msg, 1000));
+
+    const auto m = A.metricsSnapshot();
+    ASSERT_EQ(m.size(), 2u);
+    EXPECT_EQ(m[0].peer, 2);
+    EXPECT_EQ(m[0].messagesReceived, 1u);
+    EXPECT_EQ(m[0].bytesReceived, 50u);
+    EXPECT_EQ(m[0].queueDepth, 1u);
+    EXPECT_EQ(m[1].peer, 3);
+    EXPECT_EQ(m[1].messagesReceived, 1u);
+    EXPECT_EQ(m[1].queueDepth, 0u);
+    EXPECT_EQ(m[1].recvWait.count, 1u);
+
+    const auto sent = B.metricsSnapshot();
+    EXPECT_EQ(sent[0].peer, 1);
+    EXPECT_EQ(sent[0].messagesSent, 2u);
+    EXPECT_EQ(sent[0].bytesSent, 150u);
+    EXPECT_EQ(sent[0].sendLatency.count, 2u);
+
+    ASSERT_TRUE(A.routerReceiveRound(2, 1, msg, 1000));
+    EXPECT_EQ(A.metricsSnapshot()[0].queueDepth, 0u);
+    const std::string text = A.metricsText();
+    EXPECT_NE(text.find("sc_messages_received_total{party=\"1\",peer=\"2\"} 2"), std::string::npos);
+    EXPECT_NE(text.find("sc_bytes_received_total{party=\"1\",peer=\"2\"} 150"), std::string::npos);
+
+    A.resetMetrics();
+    EXPECT_EQ(A.metricsSnapshot()[0].messagesReceived, 0u);
+}
+
+TEST(CommunicatorTest, BusyPollReceivesBothDuringAndAfterTheSpin) {
+    const int base = 10220;
+    const int num_parties = 2;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    A.setBusyPoll(200);
+    B.setBusyPoll(200);
+    EXPECT_EQ(A.getBusyPoll(), 200);
+    for (Communicator* c : {&A, &B}) c->setUpRouterDealer();
+    bool bReady = false;
+    std::thread readyB([&]() { bReady = B.awaitMeshReady(5000); });
+    const bool aReady = A.awaitMeshReady(5000);
+    readyB.join();
+    ASSERT_TRUE(aReady && bReady);
+
+    // Arrives within the spin budget
+    std::thread early([&]() { ASSERT_TRUE(B.dealerSendTo(1, "early")); });
+    zmq::message_t msg;
+    ASSERT_TRUE(A.routerReceiveFrom(2, msg, 2000));
+    EXPECT_EQ(msg.to_string(), "early");
+    early.join();
+
+    // Arrives long after the spin gave way to a blocking poll
+    std::thread late([&]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        ASSERT_TRUE(B.dealerSendTo(1, "late"));
+    });
+    ASSERT_TRUE(A.routerReceiveFrom(2, msg, 2000));
+    EXPECT_EQ(msg.to_string(), "late");
+    late.join();
+}
+
+// A receive timeout shorter than the spin budget bounds the whole wait
+TEST(CommunicatorTest, BusyPollSubReceiveHonorsShortTimeouts) {
+    Communicator S{2, 10300, "127.0.0.1", 2};
+    S.setUpSubscribers();
+    S.setBusyPoll(500000); // 500 ms of spinning
+    int from = -1;
+    zmq::message_t msg;
+    const auto start = std::chrono::steady_clock::now();
+    EXPECT_FALSE(S.subReceive(from, msg, 20));
+    EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::milliseconds(250));
+}
+
+// Sent payloads come back to the pool once ZeroMQ is done with them, so a steady stream of
+// sends stops allocating after the first few
+TEST(CommunicatorTest, SendsRecyclePooledBuffers) {
+    const int base = 10230;
+    const int num_parties = 2;
+    Communicator A{1, base, "127.0.0.1", num_parties};
+    Communicator B{2, base, "127.0.0.1", num_parties};
+    for (Communicator* c : {&A, &B}) c->setUpRouterDealer();
+    bool bReady = false;
+    std::thread readyB([&]() { bReady = B.awaitMeshReady(5000); });
+    const bool aReady = A.awaitMeshReady(5000);
+    readyB.join();
+    ASSERT_TRUE(aReady && bReady);
+
+    const int rounds = 200;
+    const BufferPool::Stats before = B.bufferPool().stats();
+    zmq::message_t msg;
+    for (int r = 0; r < rounds; ++r) {
+        std::string payload(1024, static_cast<char>('a' + r % 26));
+        ASSERT_TRUE(B.dealerSendTo(1, payload));
+        ASSERT_TRUE(A.routerReceiveFrom(2, msg, 2000));
+        ASSERT_EQ(msg.to_string(), payload);
+    }
+    const BufferPool::Stats after = B.bufferPool().stats();
+    EXPECT_EQ(after.allocations - before.allocations, static_cast<uint64_t>(rounds));
+    EXPECT_LE(after.fresh - before.fresh, static_cast<uint64_t>(rounds / 2));
+
+    // Inline-sized payloads and a disabled pool leave it alone
+    ASSERT_TRUE(B.dealerSendTo(1, std::string(Communicator::kInlineMessage, 's')));
+    B.setBufferPoolEnabled(false);
+    ASSERT_TRUE(B.dealerSendTo(1, std::string(4096, 'u')));
+    EXPECT_EQ(B.bufferPool().stats().allocations, after.allocations);
+    ASSERT_TRUE(A.routerReceiveFrom(2, msg, 2000));
+    EXPECT_EQ(msg.size(), Communicator::kInlineMessage);
+    ASSERT_TRUE(A.routerReceiveFrom(2, msg, 2000));
+    EXPECT_EQ(msg.to_string(), std::string(4096, 'u'));
+}
+
 TEST(CommunicatorTest, TimingOfDealerSendToTargetsSpecificPeer) {
     const int num_parties = 2;
     // Create the sender Communicator in this (main) thread, but delay dealer setup
@@ -311,6 +1199,80 @@ TEST(CommunicatorTest, DealerSendToAllParallelSendsToAllPeers) {
     }
 }
 
+TEST(CommunicatorTest, DealerSendToAllSharesOnePayloadAcrossPeers) {
+    const int num_parties = 4;
+    const int senderId = 1;
+    std::string payload(1024 * 1024, 'z'); // large enough to take zmq's ref-counted path
+    payload[0] = 'a';
+    payload[payload.size() - 1] = 'b';
+
+    std::vector<std::string> msgById(num_parties + 1);
+    std::vector<std::thread> rxs;
+    for (int rid = 2; rid <= num_parties; ++rid) {
+        rxs.emplace_back([&, rid]() {
+            Communicator R{rid, BASE_PORT, "127.0.0.1", num_parties};
+            R.setUpRouter();
+            std::string from, msg;
+            // Two broadcasts: sequential path, then parallel path
+            for (int k = 0; k < 2; ++k) {
+                if (!R.routerReceive(from, msg, 5000)) break;
+                msgById[rid] += (msg == payload) ? "ok" : "bad";
+            }
+        });
+    }
+
+    Communicator S{senderId, BASE_PORT, "127.0.0.1", num_parties};
+    S.setUpPerPeerDealers();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    ASSERT_TRUE(S.dealerSendToAll(payload));
+    ASSERT_TRUE(S.dealerSendToAllParallel(payload));
+
+    for (auto& t : rxs) if (t.joinable()) t.join();
+    for (int rid = 2; rid <= num_parties; ++rid) {
+        EXPECT_EQ(msgById[rid], "okok") << "receiver id=" << rid;
+    }
+}
+
+TEST(CommunicatorTest, DealerSendToAllParallelReusesLanesAcrossRounds) {
+    const int num_parties = 4;
+    const int senderId = 1;
+    const int rounds = 50;
+
+    // Each receiver counts the rounds it saw, in order
+    std::vector<int> received(num_parties + 1, 0);
+    std::vector<uint8_t> inOrder(num_parties + 1, 1);
+
+    std::vector<std::thread> rxs;
+    for (int rid = 2; rid <= num_parties; ++rid) {
+        rxs.emplace_back([&, rid]() {
+            Communicator R{rid, BASE_PORT, "127.0.0.1", num_parties};
+            R.setUpRouter();
+            std::string from, msg;
+            for (int r = 0; r < rounds; ++r) {
+                if (!R.routerReceive(from, msg, 5000)) break;
+                if (msg != "round-" + std::to_string(r)) inOrder[rid] = 0;
+                ++received[rid];
+            }
+        });
+    }
+
+    Communicator S{senderId, BASE_PORT, "127.0.0.1", num_parties};
+    S.setUpPerPeerDealers();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    // Same pool lanes serve every round; no per-call thread creation
+    for (int r = 0; r < rounds; ++r) {
+        ASSERT_TRUE(S.dealerSendToAllParallel("round-" + std::to_string(r)));
+    }
+
+    for (auto& t : rxs) if (t.joinable()) t.join();
+    for (int rid = 2; rid <= num_parties; ++rid) {
+        EXPECT_EQ(received[rid], rounds) << "receiver id=" << rid;
+        EXPECT_TRUE(inOrder[rid]) << "receiver id=" << rid;
+    }
+}
+
 TEST(CommunicatorTest, TimingOfDealerSendToAllParallelAcrossPartyCounts) {
     // Measure timing as number of parties increases using dealerSendToAllParallel; sender 1 sends 1MB to all others
     using clock = std::chrono::steady_clock;
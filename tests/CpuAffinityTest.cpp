@@ -0,0 +1,44 @@
+#include <gtest/gtest.h>
+#include "CpuAffinity.h"
+#include <atomic>
+#include <thread>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+TEST(CpuAffinityTest, ParsesCoreLists) {
+    EXPECT_EQ(cpu::parseCoreList("3"), (std::vector<int>{3}));
+    EXPECT_EQ(cpu::parseCoreList("0,2,4-7"), (std::vector<int>{0, 2, 4, 5, 6, 7}));
+    EXPECT_TRUE(cpu::parseCoreList("").empty());
+    EXPECT_TRUE(cpu::parseCoreList("1,x").empty());
+    EXPECT_TRUE(cpu::parseCoreList("5-2").empty());
+    EXPECT_TRUE(cpu::parseCoreList("-1").empty());
+    EXPECT_TRUE(cpu::parseCoreList("0-999999").empty()); // rejected before expanding the range
+    EXPECT_TRUE(cpu::parseCoreList("1,4096").empty());
+}
+
+#ifdef __linux__
+TEST(CpuAffinityTest, PinsCurrentAndOtherThreads) {
+    EXPECT_FALSE(cpu::pinCurrentThread(std::vector<int>{}));
+    EXPECT_FALSE(cpu::pinCurrentThread(-1));
+
+    int cpuSeen = -1;
+    std::thread t([&]() {
+        ASSERT_TRUE(cpu::pinCurrentThread(0));
+        cpuSeen = sched_getcpu();
+    });
+    t.join();
+    EXPECT_EQ(cpuSeen, 0);
+
+    std::atomic<bool> go{false};
+    std::thread other([&]() {
+        while (!go.load()) cpu::relax();
+        cpuSeen = sched_getcpu();
+    });
+    EXPECT_TRUE(cpu::pinThread(other, 0));
+    go = true;
+    other.join();
+    EXPECT_EQ(cpuSeen, 0);
+}
+#endif
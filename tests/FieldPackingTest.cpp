@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <random>
+#include <vector>
+
+#include "FieldPacking.h"
+
+// The project's field: Q = 8380417 < 2^23
+static const uint64_t kQ = 8380417;
+
+TEST(FieldPackingTest, BitsForSmallPrimeField) {
+    EXPECT_EQ(fieldpack::bitsFor(kQ), 23u);
+    EXPECT_EQ(fieldpack::bitsFor(2), 1u);
+    EXPECT_EQ(fieldpack::bitsFor(256), 8u);
+    EXPECT_EQ(fieldpack::bitsFor(257), 9u);
+    // 23-bit elements: 4096 shares take 11776 bytes instead of 32768 (about 64% fewer)
+    EXPECT_EQ(fieldpack::packedSize(4096, 23), 11776u);
+}
+
+// Every width, and counts on both sides of the 8-value SIMD group boundary
+TEST(FieldPackingTest, RoundTripsAllWidthsAndTailLengths) {
+    std::mt19937_64 gen(12345);
+    const std::vector<size_t> counts = {0, 1, 7, 8, 9, 15, 16, 17, 63, 64, 65, 1000, 1001};
+    for (unsigned bits = 1; bits <= 64; ++bits) {
+        const uint64_t mask = bits == 64 ? ~0ull : ((1ull << bits) - 1);
+        for (size_t n : counts) {
+            std::vector<uint64_t> in(n), out(n, 0xdeadbeef);
+            for (auto& v : in) v = gen() & mask;
+            std::vector<uint8_t> packed(fieldpack::packedSize(n, bits));
+            fieldpack::pack(in.data(), n, bits, packed.data());
+            fieldpack::unpack(packed.data(), n, bits, out.data());
+            ASSERT_EQ(out, in) << "bits=" << bits << " count=" << n;
+        }
+    }
+}
+
+TEST(FieldPackingTest, PackIgnoresBitsAboveWidth) {
+    const std::vector<uint64_t> in = {kQ - 1, (1ull << 40) | 5, ~0ull};
+    std::vector<uint8_t> packed(fieldpack::packedSize(in.size(), 23));
+    fieldpack::pack(in.data(), in.size(), 23, packed.data());
+    std::vector<uint64_t> out(in.size());
+    fieldpack::unpack(packed.data(), out.size(), 23, out.data());
+    EXPECT_EQ(out[0], kQ - 1);
+    EXPECT_EQ(out[1], 5u);
+    EXPECT_EQ(out[2], (1ull << 23) - 1);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+#include "hybrid_channel.h"
+#include <functional>
+#include <thread>
+#include <vector>
+
+static_assert(IsChannel<HybridChannel<3>>::value, "hybrid adapter is a channel");
+
+static void runThreads(int n, const std::function<void(int)>& body) {
+    std::vector<std::thread> threads;
+    for (int id = 1; id <= n; ++id) threads.emplace_back(body, id);
+    for (auto& t : threads) t.join();
+}
+
+static std::vector<char> payload(int from, size_t index, size_t len) {
+    std::vector<char> p(len);
+    for (size_t k = 0; k < len; ++k) p[k] = static_cast<char>(from * 31 + index * 7 + k);
+    return p;
+}
+
+TEST(HybridChannelTest, CalibrationAgreesPerPairAndOrderHoldsAcrossPaths) {
+    const int N = 3;
+    // Alternate between the NetIOMP (< 1000 bytes) and Communicator paths
+    const std::vector<size_t> sizes = {10, 5000, 20, 3000, 1, 999, 1000};
+    size_t thresholds[N + 1][N + 1] = {};
+    std::vector<int> mismatches(N + 1, 0);
+
+    runThreads(N, [&](int id) {
+        Communicator comm(id, 15420, "127.0.0.1", N);
+        comm.setUpRouterDealer();
+        ASSERT_TRUE(comm.awaitMeshReady(10000));
+        NetIOMP<N> io(id, 42400);
+        HybridChannel<N> ch(comm, io, 10000);
+
+        EXPECT_TRUE(ch.calibrate({64, 4096, 65536}, 5));
+        for (int peer = 1; peer <= N; ++peer) {
+            if (peer != id) thresholds[id][peer] = ch.threshold(peer);
+        }
+
+        for (int peer = 1; peer <= N; ++peer) {
+            if (peer != id) ch.set_threshold(peer, 1000);
+        }
+        for (int peer = 1; peer <= N; ++peer) {
+            if (peer == id) continue;
+            for (size_t i = 0; i < sizes.size(); ++i) {
+                const auto p = payload(id, i, sizes[i]);
+                EXPECT_TRUE(ch.send(peer, p.data(), p.size()));
+            }
+        }
+        ch.flush();
+        for (int peer = 1; peer <= N; ++peer) {
+            if (peer == id) continue;
+            for (size_t i = 0; i < sizes.size(); ++i) {
+                std::vector<char> got(sizes[i]);
+                EXPECT_TRUE(ch.recv(peer, got.data(), got.size()));
+                if (got != payload(peer, i, sizes[i])) ++mismatches[id];
+            }
+        }
+    });
+
+    for (int i = 1; i <= N; ++i) {
+        EXPECT_EQ(mismatches[i], 0) << "party " << i;
+        for (int j = i + 1; j <= N; ++j) EXPECT_EQ(thresholds[i][j], thresholds[j][i]) << i << "-" << j;
+    }
+}
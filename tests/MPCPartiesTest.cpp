@@ -65,8 +65,112 @@ TEST(MPCPartiesTest, NPartyAllToAllSumThreaded) {
     }
 }
 
+// Same protocol, but fan-in uses one gather per round instead of N-1 routerReceive calls
+TEST(MPCPartiesTest, NPartyAllToAllSumGather) {
+    const int N = 20;
+    const int base = 15100; // separate port base
+    const std::string host = "127.0.0.1";
+
+    const int expected_sum = (N * (N + 1)) / 2; // 1..N
+    std::vector<int> totals(N, 0);
+    std::vector<std::thread> threads;
+    threads.reserve(N);
+    std::vector<uint8_t> okFlags(N, 1);
+
+    for (int i = 0; i < N; ++i) {
+        threads.emplace_back([i, N, base, host, &totals, &okFlags]() {
+            const int id = i + 1;
+            Communicator me(id, base, host, N);
+            me.setUpRouterDealer();
+
+            if (!me.dealerSendToAll(std::to_string(id))) {
+                okFlags[i] = 0;
+            }
+
+            std::vector<zmq::message_t> shares;
+            std::vector<int> missing;
+            if (!me.routerReceiveFromAll(shares, missing, 10000)) {
+                okFlags[i] = 0;
+                return;
+            }
+            int sum = id;
+            for (int peer = 1; peer <= N; ++peer) {
+                if (peer == id) continue;
+                sum += std::stoi(shares[peer].to_string());
+            }
+            totals[i] = sum;
+        });
+    }
+
+    for (auto& t : threads) t.join();
+    for (int i = 0; i < N; ++i) {
+        EXPECT_TRUE(okFlags[i]) << "party " << (i+1) << " had a comms failure";
+        EXPECT_EQ(totals[i], expected_sum) << "party " << (i+1) << " wrong total";
+    }
+}
+
+// Vector variant: each party holds a share vector and sums all parties' vectors mod Q,
+// exchanging binary uint64 payloads instead of decimal strings
+TEST(MPCPartiesTest, NPartyAllToAllVectorSumModQ) {
+    const int N = 10;
+    const int base = 15200; // separate port base
+    const std::string host = "127.0.0.1";
+    const uint64_t Q = 8380417;
+    const size_t len = 4096;
+
+    // Party id's share at index k is (id * 7919 + k) mod Q
+    auto share = [Q](int id, size_t k) { return (static_cast<uint64_t>(id) * 7919u + k) % Q; };
+    std::vector<uint8_t> okFlags(N, 1);
+    std::vector<std::vector<uint64_t>> totals(N);
+    std::vector<std::thread> threads;
+    threads.reserve(N);
+
+    for (int i = 0; i < N; ++i) {
+        threads.emplace_back([&, i]() {
+            const int id = i + 1;
+            Communicator me(id, base, host, N);
+            me.setUpRouterDealer();
+
+            std::vector<uint64_t> mine(len);
+            for (size_t k = 0; k < len; ++k) mine[k] = share(id, k);
+            for (int peer = 1; peer <= N; ++peer) {
+                if (peer != id && !me.sendVec(peer, mine)) okFlags[i] = 0;
+            }
+
+            std::vector<uint64_t> acc = mine;
+            std::vector<uint64_t> theirs;
+            for (int peer = 1; peer <= N; ++peer) {
+                if (peer == id) continue;
+                if (!me.recvVec(peer, theirs, 10000) || theirs.size() != len) {
+                    okFlags[i] = 0;
+                    return;
+                }
+                for (size_t k = 0; k < len; ++k) acc[k] = (acc[k] + theirs[k]) % Q;
+            }
+            totals[i] = std::move(acc);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    std::vector<uint64_t> expected(len, 0);
+    for (int id = 1; id <= N; ++id) {
+        for (size_t k = 0; k < len; ++k) expected[k] = (expected[k] + share(id, k)) % Q;
+    }
+    for (int i = 0; i < N; ++i) {
+        EXPECT_TRUE(okFlags[i]) << "party " << (i+1) << " had a comms failure";
+        EXPECT_EQ(totals[i], expected) << "party " << (i+1) << " wrong total";
+    }
+}
+
+// How run_send_test fans the payload out to peers
+enum class SendMode {
+    Sequential, // one dealerSendTo per peer (one payload copy per peer)
+    Parallel,   // dealerSendToAllParallel (pooled lanes, shared payload)
+    Shared      // dealerSendToAll (single thread, shared payload)
+};
+
 // Helper function to run a communication test and measure send time
-static std::chrono::milliseconds run_send_test(int N, const std::string& data, bool use_sequential_send) {
+static std::chrono::milliseconds run_send_test(int N, const std::string& data, SendMode mode) {
     const int base_port = 17000;
     const std::string host = "127.0.0.1";
     std::vector<std::thread> threads;
@@ -76,22 +180,26 @@ static std::chrono::milliseconds run_send_test(int N, const std::string& data, b
     auto start_time = std::chrono::high_resolution_clock::now();
 
     for (int i = 0; i < N; ++i) {
-        threads.emplace_back([i, N, base_port, host, &data, use_sequential_send, &okFlags]() {
+        threads.emplace_back([i, N, base_port, host, &data, mode, &okFlags]() {
             const int id = i + 1;
             Communicator me(id, base_port, host, N);
             me.setUpRouterDealer();
 
-            if (use_sequential_send) {
+            if (mode == SendMode::Sequential) {
                 for (int peer = 1; peer <= N; ++peer) {
                     if (peer == id) continue;
                     if (!me.dealerSendTo(peer, data)) {
                         okFlags[i] = false;
                     }
                 }
-            } else {
+            } else if (mode == SendMode::Parallel) {
                 if (!me.dealerSendToAllParallel(data)) {
                     okFlags[i] = false;
                 }
+            } else {
+                if (!me.dealerSendToAll(data)) {
+                    okFlags[i] = false;
+                }
             }
 
             // Still need to receive messages to allow sends to complete
@@ -119,7 +227,7 @@ TEST(MPCPartiesTest, SendToAllPerformanceComparison) {
 
     std::cout << std::endl;
     std::cout << "--- Send-To-All Performance Comparison ---" << std::endl;
-    std::cout << "N, DataSize (B), Sequential (ms), Parallel (ms)" << std::endl;
+    std::cout << "N, DataSize (B), Sequential (ms), Parallel (ms), Shared (ms)" << std::endl;
 
     for (int n : party_counts) {
         for (size_t size : data_sizes) {
@@ -127,22 +235,27 @@ TEST(MPCPartiesTest, SendToAllPerformanceComparison) {
 
             long long seq_total_ms = 0;
             long long par_total_ms = 0;
+            long long shared_total_ms = 0;
 
             for (int it = 0; it < iterations; ++it) {
-                auto seq_duration = run_send_test(n, data, true);
+                auto seq_duration = run_send_test(n, data, SendMode::Sequential);
                 // small pause between runs to avoid port/socket reuse flakiness
                 std::this_thread::sleep_for(std::chrono::milliseconds(20));
-                auto par_duration = run_send_test(n, data, false);
+                auto par_duration = run_send_test(n, data, SendMode::Parallel);
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+                auto shared_duration = run_send_test(n, data, SendMode::Shared);
                 std::this_thread::sleep_for(std::chrono::milliseconds(20));
                 seq_total_ms += seq_duration.count();
                 par_total_ms += par_duration.count();
+                shared_total_ms += shared_duration.count();
             }
 
             double seq_avg = static_cast<double>(seq_total_ms) / iterations;
             double par_avg = static_cast<double>(par_total_ms) / iterations;
+            double shared_avg = static_cast<double>(shared_total_ms) / iterations;
 
             std::cout << std::fixed << std::setprecision(1)
-                      << n << ", " << size << ", " << seq_avg << ", " << par_avg << std::endl;
+                      << n << ", " << size << ", " << seq_avg << ", " << par_avg << ", " << shared_avg << std::endl;
         }
     }
     std::cout << "----------------------------------------" << std::endl;
@@ -6,6 +6,8 @@
 
 // NetIOMP local headers
 #include "netmp.h"
+#include "netmp_packed.h"
+#include "netmp_pool.h"
 
 // Timing test similar to CommunicatorTest.TimingOfDealerSendAcrossPayloadSizes
 // Uses 2 parties (1 sender, 2 receiver/ACK).
@@ -89,6 +91,189 @@ TEST(NetIOMPTest, TimingAcrossPayloadSizes) {
     if (t2.joinable()) t2.join();
 }
 
+TEST(NetIOMPTest, SendVecRoundTripsUint64Shares) {
+    const int base_port = 42050;
+    const size_t count = 100000;
+    std::vector<uint64_t> got;
+
+    std::thread t2([&]() {
+        NetIOMP<2> io(2, base_port);
+        io.recv_vec(1, got);
+        // Echo back so both directions are exercised
+        io.send_vec(1, got);
+        io.flush();
+    });
+
+    NetIOMP<2> io1(1, base_port);
+    std::vector<uint64_t> shares(count);
+    for (size_t i = 0; i < count; ++i) shares[i] = (i * 0x9E3779B97F4A7C15ull) ^ (i << 40);
+    io1.send_vec(2, shares);
+    io1.flush();
+
+    std::vector<uint64_t> echoed;
+    io1.recv_vec(2, echoed);
+    if (t2.joinable()) t2.join();
+
+    EXPECT_EQ(got, shares);
+    EXPECT_EQ(echoed, shares);
+}
+
+// Busy-poll receives must deliver the same bytes whether data is already queued or arrives
+// after the spin budget has run out and the read blocks
+TEST(NetIOMPTest, BusyPollReceivesMatchBlockingOnes) {
+    const int base_port = 42080;
+    const size_t count = 100000;
+    std::vector<uint64_t> got;
+
+    std::thread t2([&]() {
+        NetIOMP<2> io(2, base_port);
+        io.set_busy_poll(50);
+        io.recv_vec(1, got);
+        io.send_vec(1, got);
+        io.flush();
+    });
+
+    NetIOMP<2> io1(1, base_port);
+    io1.set_busy_poll(50);
+    std::vector<uint64_t> shares(count);
+    for (size_t i = 0; i < count; ++i) shares[i] = i * 0x9E3779B97F4A7C15ull;
+    std::this_thread::sleep_for(std::chrono::milliseconds(20)); // party 2 outspins its budget
+    io1.send_vec(2, shares);
+    io1.flush();
+
+    std::vector<uint64_t> echoed;
+    io1.recv_vec(2, echoed);
+    if (t2.joinable()) t2.join();
+
+    EXPECT_EQ(got, shares);
+    EXPECT_EQ(echoed, shares);
+}
+
+// Framed receives land in pooled blocks; after the first frames every one reuses a block
+TEST(NetIOMPTest, FramedMessagesReusePooledBuffers) {
+    const int base_port = 42030;
+    const int rounds = 200;
+    const std::vector<size_t> sizes = { 0u, 40u, 1000u, 70000u };
+    BufferPool pool;
+    bool ok = true;
+
+    std::thread t2([&]() {
+        NetIOMP<2> io(2, base_port);
+        for (int r = 0; r < rounds; ++r) {
+            for (size_t sz : sizes) {
+                PooledBuffer buf = recv_framed(io, 1, pool);
+                const auto* p = static_cast<const uint8_t*>(buf.data());
+                ok = ok && buf.size() == sz;
+                for (size_t i = 0; ok && i < sz; ++i) ok = p[i] == static_cast<uint8_t>(r + i);
+            }
+        }
+    });
+
+    NetIOMP<2> io1(1, base_port);
+    std::vector<uint8_t> payload(sizes.back());
+    for (int r = 0; r < rounds; ++r) {
+        for (size_t sz : sizes) {
+            for (size_t i = 0; i < sz; ++i) payload[i] = static_cast<uint8_t>(r + i);
+            send_framed(io1, 2, payload.data(), sz);
+        }
+    }
+    io1.flush();
+    if (t2.joinable()) t2.join();
+
+    EXPECT_TRUE(ok);
+    const BufferPool::Stats st = pool.stats();
+    EXPECT_EQ(st.allocations, static_cast<uint64_t>(rounds * sizes.size()));
+    EXPECT_LE(st.fresh, sizes.size());
+    EXPECT_EQ(st.outstanding, 0u); // the receiving thread returned its cached blocks as it exited
+}
+
+TEST(NetIOMPTest, SendPackedRoundTripsFieldElements) {
+    const int base_port = 42060;
+    const uint64_t Q = 8380417;
+    const unsigned bits = fieldpack::bitsFor(Q);
+    const size_t count = 100001;
+    std::vector<uint64_t> got;
+
+    std::thread t2([&]() {
+        NetIOMP<2> io(2, base_port);
+        recv_packed(io, 1, got, bits);
+        send_packed(io, 1, got, bits);
+        io.flush();
+    });
+
+    NetIOMP<2> io1(1, base_port);
+    std::vector<uint64_t> shares(count);
+    for (size_t i = 0; i < count; ++i) shares[i] = (i * 0x9E3779B97F4A7C15ull) % Q;
+    send_packed(io1, 2, shares, bits);
+    io1.flush();
+
+    std::vector<uint64_t> echoed;
+    recv_packed(io1, 2, echoed, bits);
+    if (t2.joinable()) t2.join();
+
+    EXPECT_EQ(got, shares);
+    EXPECT_EQ(echoed, shares);
+}
+
+// Same exchange over shared memory; 4 MiB per direction wraps the 1 MiB rings several times
+TEST(NetIOMPTest, ShmIORoundTripsLargeVectors) {
+    const int base_port = 42070;
+    const size_t count = 512 * 1024;
+    std::vector<uint64_t> got;
+
+    std::thread t2([&]() {
+        NetIOMP<2, ShmIO> io(2, base_port);
+        io.recv_vec(1, got);
+        io.send_vec(1, got);
+        io.flush();
+    });
+
+    NetIOMP<2, ShmIO> io1(1, base_port);
+    std::vector<uint64_t> shares(count);
+    for (size_t i = 0; i < count; ++i) shares[i] = (i * 0x9E3779B97F4A7C15ull) ^ (i << 40);
+    io1.send_vec(2, shares);
+    io1.flush();
+
+    std::vector<uint64_t> echoed;
+    io1.recv_vec(2, echoed);
+    if (t2.joinable()) t2.join();
+
+    EXPECT_EQ(got, shares);
+    EXPECT_EQ(echoed, shares);
+}
+
+// Small-message round trip, TCP vs shared memory
+template <typename IO>
+static double pingpong_avg_us(int base_port, int iterations) {
+    std::thread t2([&]() {
+        NetIOMP<2, IO> io(2, base_port);
+        uint64_t v = 0;
+        for (int i = 0; i < iterations; ++i) {
+            io.recv_data(1, &v, sizeof(v));
+            io.send_data(1, &v, sizeof(v));
+            io.flush();
+        }
+    });
+    NetIOMP<2, IO> io1(1, base_port);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        uint64_t v = static_cast<uint64_t>(i);
+        io1.send_data(2, &v, sizeof(v));
+        io1.flush();
+        io1.recv_data(2, &v, sizeof(v));
+    }
+    auto end = std::chrono::steady_clock::now();
+    if (t2.joinable()) t2.join();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+TEST(NetIOMPTest, ShmIOVersusNetIORoundTrip) {
+    const int iterations = 10000;
+    const double tcp_us = pingpong_avg_us<NetIO>(42080, iterations);
+    const double shm_us = pingpong_avg_us<ShmIO>(42090, iterations);
+    std::cout << "[NetIOMP] 8B round trip: NetIO " << tcp_us << " us, ShmIO " << shm_us << " us" << std::endl;
+}
+
 // Helper to run the party-count timing test for a compile-time party count N
 template <int N>
 static void run_partycount_timing(int base_port, size_t payload_size, int iterations_warmup, int iterations) {
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "PeerMetrics.h"
+
+TEST(PeerMetricsTest, HistogramBucketsCoverValuesWithinOneEighth) {
+    // Exact below 8, then 8 linear sub-buckets per power of two
+    for (uint64_t v = 0; v < 8; ++v) EXPECT_EQ(LatencyHistogram::bucketOf(v), v);
+    size_t prev = 0;
+    for (uint64_t v = 1; v < (uint64_t(1) << 24); v = v * 5 / 4 + 1) {
+        const size_t b = LatencyHistogram::bucketOf(v);
+        EXPECT_GE(b, prev);
+        prev = b;
+        const uint64_t hi = LatencyHistogram::bucketUpperBound(b);
+        EXPECT_GE(hi, v);
+        EXPECT_LE(hi - v, v / 8) << "value " << v;
+        EXPECT_EQ(LatencyHistogram::bucketOf(hi), b);
+        EXPECT_EQ(LatencyHistogram::bucketOf(hi + 1), b + 1);
+    }
+    // Huge values saturate in the last bucket instead of overflowing
+    EXPECT_EQ(LatencyHistogram::bucketOf(~uint64_t(0)), LatencyHistogram::kBuckets - 1);
+}
+
+TEST(PeerMetricsTest, HistogramPercentilesTrackRecordedValues) {
+    LatencyHistogram h;
+    EXPECT_EQ(h.snapshot().percentile(0.5), 0u);
+    for (uint64_t v = 1; v <= 1000; ++v) h.record(v * 1000); // 1 us .. 1 ms
+    const auto s = h.snapshot();
+    EXPECT_EQ(s.count, 1000u);
+    EXPECT_EQ(s.maxNs, 1000000u);
+    EXPECT_DOUBLE_EQ(s.meanNs(), 500500.0);
+    const uint64_t p50 = s.percentile(0.5);
+    const uint64_t p99 = s.percentile(0.99);
+    EXPECT_GE(p50, 500000u);
+    EXPECT_LE(p50, 500000u + 500000u / 8);
+    EXPECT_GE(p99, 990000u);
+    EXPECT_LE(p99, 1000000u);
+    EXPECT_EQ(s.percentile(1.0), 1000000u);
+
+    h.reset();
+    EXPECT_EQ(h.snapshot().count, 0u);
+}
+
+TEST(PeerMetricsTest, ConcurrentRecordsAreNotLost) {
+    PeerCounters c;
+    const int threads = 4;
+    const int perThread = 20000;
+    std::vector<std::thread> ts;
+    for (int t = 0; t < threads; ++t) {
+        ts.emplace_back([&, t]() {
+            for (int i = 0; i < perThread; ++i) {
+                c.messagesSent.fetch_add(1, std::memory_order_relaxed);
+                c.sendLatency.record(static_cast<uint64_t>(t * 100 + i % 100));
+            }
+        });
+    }
+    for (auto& t : ts) t.join();
+    const PeerMetrics m = snapshotPeer(2, c);
+    EXPECT_EQ(m.messagesSent, uint64_t(threads) * perThread);
+    EXPECT_EQ(m.sendLatency.count, uint64_t(threads) * perThread);
+    EXPECT_EQ(m.sendLatency.maxNs, 399u);
+}
+
+TEST(PeerMetricsTest, TextFormatHasOneSeriesPerPeer) {
+    PeerCounters a, b;
+    a.messagesSent = 3;
+    a.bytesSent = 300;
+    a.messagesArrived = 5;
+    a.messagesReceived = 4;
+    a.recvWait.record(2000);
+    b.sendFailures = 1;
+    const std::string text = formatMetricsText(1, {snapshotPeer(2, a), snapshotPeer(3, b)});
+    EXPECT_NE(text.find("# TYPE sc_messages_sent_total counter\n"), std::string::npos);
+    EXPECT_NE(text.find("sc_messages_sent_total{party=\"1\",peer=\"2\"} 3\n"), std::string::npos);
+    EXPECT_NE(text.find("sc_bytes_sent_total{party=\"1\",peer=\"2\"} 300\n"), std::string::npos);
+    EXPECT_NE(text.find("sc_send_failures_total{party=\"1\",peer=\"3\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("sc_queue_depth{party=\"1\",peer=\"2\"} 1\n"), std::string::npos);
+    EXPECT_NE(text.find("sc_recv_wait_ns{party=\"1\",peer=\"2\",quantile=\"0.5\"} 2000\n"), std::string::npos);
+    EXPECT_NE(text.find("sc_recv_wait_ns_count{party=\"1\",peer=\"2\"} 1\n"), std::string::npos);
+}
@@ -0,0 +1,61 @@
+#include <gtest/gtest.h>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "Trace.h"
+
+namespace {
+size_t countOf(const std::string& text, const std::string& needle) {
+    size_t n = 0;
+    for (size_t pos = text.find(needle); pos != std::string::npos; pos = text.find(needle, pos + 1)) ++n;
+    return n;
+}
+} // namespace
+
+// The tracer classes are always built; only the SC_TRACE_* hooks depend on SC_ENABLE_TRACING
+TEST(TraceTest, ExportsOneTrackPerPartyWithPerThreadEvents) {
+    std::vector<std::thread> parties;
+    for (int party = 101; party <= 103; ++party) {
+        parties.emplace_back([party]() {
+            for (int peer = 101; peer <= 103; ++peer) {
+                if (peer == party) continue;
+                sctrace::Scope send(sctrace::Op::Send, party, peer, 64);
+            }
+            sctrace::Scope recv(sctrace::Op::Recv, party);
+            recv.set(party == 101 ? 102 : 101, 32); // sender learned on completion
+        });
+    }
+    for (auto& t : parties) t.join();
+
+    std::ostringstream out;
+    sctrace::Tracer::instance().writeChromeJson(out);
+    const std::string json = out.str();
+    EXPECT_EQ(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    EXPECT_EQ(json.substr(json.size() - 4), "\n]}\n");
+    for (int party = 101; party <= 103; ++party) {
+        const std::string pid = "\"pid\":" + std::to_string(party) + ",";
+        EXPECT_EQ(countOf(json, "\"name\":\"send\",\"ph\":\"X\"," + pid), 2u) << json;
+        EXPECT_EQ(countOf(json, "\"name\":\"recv\",\"ph\":\"X\"," + pid), 1u);
+        EXPECT_EQ(countOf(json, "{\"name\":\"process_name\",\"ph\":\"M\"," + pid + "\"args\":{\"name\":\"party " + std::to_string(party) + "\"}}"), 1u);
+    }
+    EXPECT_EQ(countOf(json, "\"args\":{\"peer\":102,\"bytes\":32}"), 1u);
+}
+
+TEST(TraceTest, RingKeepsTheNewestEventsWhenFull) {
+    sctrace::ThreadRing ring(1);
+    const size_t total = sctrace::ThreadRing::kCapacity + 10;
+    for (size_t i = 0; i < total; ++i) {
+        sctrace::Event e;
+        e.startNs = i;
+        ring.push(e);
+    }
+    size_t seen = 0;
+    uint64_t first = 0;
+    ring.forEach([&](const sctrace::Event& e) {
+        if (seen++ == 0) first = e.startNs;
+    });
+    EXPECT_EQ(seen, sctrace::ThreadRing::kCapacity);
+    EXPECT_EQ(first, 10u);
+}
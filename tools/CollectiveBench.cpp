@@ -0,0 +1,501 @@
+#include "Collectives.h"
+#include "Communicator.h"
+#include "CommunicatorChannel.h"
+#include "PeerMetrics.h"
+#include "hybrid_channel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+// Collective-pattern benchmark with one OS process per party. For every backend and party
+// count N the launcher forks N children on localhost; each child runs every pattern x payload
+// size, and before each round all parties meet at a barrier in a shared anonymous mapping.
+// The last party to arrive stamps the release time, every party records when its own part of
+// the round finished, and the launcher reports round latency = slowest party's finish time
+// after release (plus the mean party's, which shows straggler skew).
+//
+// Patterns (party 1 is the root):
+//   broadcast  root sends the payload to every peer
+//   gather     every peer sends the payload to the root
+//   alltoall   every party sends the payload to every other party
+//   allreduce  element-wise sum mod Q of size/8 uint64 values: Collectives::allreduce (ring)
+//              on zmq; a direct all-to-all exchange and local sum on NetIOMP
+// The patterns are written once against the channel interface (Channel.h) and run over both.
+// Backends: zmq (Communicator ROUTER/DEALER), netio (NetIOMP over TCP), shm (NetIOMP<N, ShmIO>),
+// hybrid (HybridChannel: NetIOMP below a per-pair size threshold calibrated at startup, zmq above).
+// NetIOMP takes the party count as a template argument, so those backends support 2..12 parties
+// (the size of IP[] in cmpc_config.h).
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+enum class Pattern { Broadcast, Gather, AllToAll, AllReduce };
+const char* patternName(Pattern p) {
+    switch (p) {
+    case Pattern::Broadcast: return "broadcast";
+    case Pattern::Gather: return "gather";
+    case Pattern::AllToAll: return "alltoall";
+    case Pattern::AllReduce: return "allreduce";
+    }
+    return "?";
+}
+
+const uint64_t kQ = 8380417;
+const int kRoot = 1;
+const int kMaxNetIOParties = 12;
+
+struct Args {
+    std::vector<int> parties = {2, 4, 8};
+    std::vector<size_t> sizes = {64, 4096, 65536};
+    std::vector<Pattern> patterns = {Pattern::Broadcast, Pattern::Gather, Pattern::AllToAll, Pattern::AllReduce};
+    std::vector<std::string> backends = {"zmq", "netio"};
+    int iters = 50;
+    int warmup = 5;
+    int base = 20000;
+    int timeoutSec = 120; // per party process; a hung peer cannot stall the launcher forever
+    std::string format = "text"; // text | csv | json
+    std::string out;
+};
+
+std::vector<std::string> splitList(const std::string& list) {
+    std::vector<std::string> items;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) items.push_back(item);
+    }
+    return items;
+}
+
+Args parseArgs(int argc, char** argv) {
+    Args a;
+    for (int i = 1; i < argc; ++i) {
+        std::string s = argv[i];
+        auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : ""; };
+        if (s == "--parties") {
+            a.parties.clear();
+            for (const auto& v : splitList(next())) a.parties.push_back(std::stoi(v));
+        } else if (s == "--sizes") {
+            a.sizes.clear();
+            for (const auto& v : splitList(next())) a.sizes.push_back(static_cast<size_t>(std::stoll(v)));
+        } else if (s == "--patterns") {
+            a.patterns.clear();
+            for (const auto& v : splitList(next())) {
+                if (v == "broadcast") a.patterns.push_back(Pattern::Broadcast);
+                else if (v == "gather") a.patterns.push_back(Pattern::Gather);
+                else if (v == "alltoall") a.patterns.push_back(Pattern::AllToAll);
+                else if (v == "allreduce") a.patterns.push_back(Pattern::AllReduce);
+                else {
+                    std::cerr << "unknown pattern " << v << "\n";
+                    std::exit(1);
+                }
+            }
+        } else if (s == "--backends") a.backends = splitList(next());
+        else if (s == "--iters") a.iters = std::max(1, std::stoi(next()));
+        else if (s == "--warmup") a.warmup = std::max(0, std::stoi(next()));
+        else if (s == "--base") a.base = std::stoi(next());
+        else if (s == "--timeout") a.timeoutSec = std::stoi(next());
+        else if (s == "--format") a.format = next();
+        else if (s == "--out") a.out = next();
+        else if (s == "-h" || s == "--help") {
+            std::cout << "Usage: collective_bench [--parties 2,4,8] [--sizes 64,4096,65536]\n"
+                         "                        [--patterns broadcast,gather,alltoall,allreduce]\n"
+                         "                        [--backends zmq,netio,shm,hybrid] [--iters 50] [--warmup 5]\n"
+                         "                        [--base 20000] [--timeout 120] [--format text|csv|json] [--out file]\n";
+            std::exit(0);
+        }
+    }
+    return a;
+}
+
+int64_t nowNs() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+// Lives in a MAP_SHARED | MAP_ANONYMOUS mapping created before fork, so every party process
+// sees the same atomics (steady_clock is CLOCK_MONOTONIC, common to all processes).
+struct SharedRun {
+    std::atomic<uint32_t> arrived{0};
+    std::atomic<uint32_t> generation{0};
+    std::atomic<uint32_t> failed{0};
+    std::atomic<int64_t> releaseNs{0};
+    // Followed by finishNs[measurement][iter][party] (uint64, ns after release)
+};
+static_assert(std::atomic<int64_t>::is_always_lock_free, "process-shared barrier needs lock-free atomics");
+
+class SharedRegion {
+public:
+    SharedRegion(size_t measurements, int iters, int n)
+        : iters_(iters), n_(n), bytes_(sizeof(SharedRun) + measurements * iters * n * sizeof(uint64_t)) {
+        void* p = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) {
+            perror("mmap");
+            std::exit(1);
+        }
+        run_ = new (p) SharedRun();
+        finish_ = reinterpret_cast<uint64_t*>(static_cast<char*>(p) + sizeof(SharedRun));
+    }
+    ~SharedRegion() { munmap(run_, bytes_); }
+    SharedRegion(const SharedRegion&) = delete;
+    SharedRegion& operator=(const SharedRegion&) = delete;
+
+    SharedRun& run() { return *run_; }
+    uint64_t& finish(size_t m, int iter, int party) {
+        return finish_[(m * iters_ + iter) * n_ + (party - 1)];
+    }
+
+    // Sense-reversing barrier across processes. Returns false once any party has failed.
+    bool barrier() {
+        SharedRun& r = *run_;
+        const uint32_t gen = r.generation.load(std::memory_order_acquire);
+        if (r.arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == static_cast<uint32_t>(n_)) {
+            r.arrived.store(0, std::memory_order_relaxed);
+            r.releaseNs.store(nowNs(), std::memory_order_relaxed);
+            r.generation.fetch_add(1, std::memory_order_release);
+        } else {
+            while (r.generation.load(std::memory_order_acquire) == gen) {
+                if (r.failed.load(std::memory_order_relaxed)) return false;
+                sched_yield(); // parties may outnumber cores
+            }
+        }
+        return !r.failed.load(std::memory_order_relaxed);
+    }
+    void fail() { run_->failed.store(1, std::memory_order_relaxed); }
+
+private:
+    SharedRun* run_ = nullptr;
+    uint64_t* finish_ = nullptr;
+    int iters_;
+    int n_;
+    size_t bytes_;
+};
+
+// One party's side of every pattern
+class Party {
+public:
+    virtual ~Party() = default;
+    virtual bool round(Pattern p, size_t bytes) = 0;
+};
+
+struct Buffers {
+    std::vector<char> send;
+    std::vector<char> recv;
+    std::vector<uint64_t> values;
+};
+
+// The patterns, written once against the channel interface (Channel.h). allreduce here is a
+// direct exchange followed by a local sum.
+template <typename Ch>
+bool runPattern(Ch& ch, Pattern p, size_t bytes, Buffers& b) {
+    const int n = ch.parties();
+    const int id = ch.party();
+    if (b.send.size() < bytes) b.send.assign(bytes, static_cast<char>(id));
+    if (b.recv.size() < bytes * n) b.recv.resize(bytes * n);
+    switch (p) {
+    case Pattern::Broadcast:
+        if (id == kRoot) {
+            if (!ch.broadcast(b.send.data(), bytes)) return false;
+            ch.flush(0);
+            return true;
+        }
+        return ch.recv(kRoot, b.recv.data(), bytes);
+    case Pattern::Gather:
+        if (id != kRoot) {
+            if (!ch.send(kRoot, b.send.data(), bytes)) return false;
+            ch.flush(kRoot);
+            return true;
+        }
+        for (int peer = 1; peer <= n; ++peer) {
+            if (peer != id && !ch.recv(peer, b.recv.data() + bytes * (peer - 1), bytes)) return false;
+        }
+        return true;
+    case Pattern::AllToAll:
+        return allToAll(ch, b.send.data(), b.recv.data(), bytes);
+    case Pattern::AllReduce: {
+        const size_t count = std::max<size_t>(1, bytes / sizeof(uint64_t));
+        const size_t len = count * sizeof(uint64_t);
+        b.values.assign(count, static_cast<uint64_t>(id));
+        if (b.recv.size() < len * n) b.recv.resize(len * n);
+        if (!allToAll(ch, b.values.data(), b.recv.data(), len)) return false;
+        for (int peer = 1; peer <= n; ++peer) {
+            if (peer == id) continue;
+            const uint64_t* theirs = reinterpret_cast<const uint64_t*>(b.recv.data() + len * (peer - 1));
+            for (size_t k = 0; k < count; ++k) b.values[k] = (b.values[k] + theirs[k]) % kQ;
+        }
+        return true;
+    }
+    }
+    return false;
+}
+
+class ZmqParty : public Party {
+public:
+    ZmqParty(int id, int n, int base) : comm_(id, base, "127.0.0.1", n), ch_(comm_, 10000), coll_(comm_, kQ) {
+        comm_.setUpRouterDealer();
+        ready_ = comm_.awaitMeshReady(10000);
+    }
+    bool ready() const { return ready_; }
+
+    bool round(Pattern p, size_t bytes) override {
+        if (p != Pattern::AllReduce) return runPattern(ch_, p, bytes, buffers_);
+        // Ring reduce-scatter + allgather rather than the direct exchange
+        buffers_.values.assign(std::max<size_t>(1, bytes / sizeof(uint64_t)), static_cast<uint64_t>(comm_.getId()));
+        return coll_.allreduce(buffers_.values, 10000);
+    }
+
+private:
+    Communicator comm_;
+    CommunicatorChannel ch_;
+    Collectives coll_;
+    bool ready_ = false;
+    Buffers buffers_;
+};
+
+template <int N, typename IO>
+class NetIOParty : public Party {
+public:
+    NetIOParty(int id, int port) : io_(id, port), ch_(io_) {}
+
+    bool round(Pattern p, size_t bytes) override { return runPattern(ch_, p, bytes, buffers_); }
+
+private:
+    NetIOMP<N, IO> io_;
+    NetIOMPChannel<N, IO> ch_;
+    Buffers buffers_;
+};
+
+template <int N>
+class HybridParty : public Party {
+public:
+    // NetIOMP<N> uses ports up to port + 2*N*N + 1; the Communicator binds above that
+    HybridParty(int id, int port) : comm_(id, port + 2 * N * N + 2, "127.0.0.1", N), io_(id, port), ch_(comm_, io_, 10000) {
+        comm_.setUpRouterDealer();
+        ready_ = comm_.awaitMeshReady(10000);
+        if (ready_ && !ch_.calibrate()) std::cerr << "party " << id << ": calibration failed, using default thresholds\n";
+    }
+    bool ready() const { return ready_; }
+
+    bool round(Pattern p, size_t bytes) override { return runPattern(ch_, p, bytes, buffers_); }
+
+private:
+    Communicator comm_;
+    NetIOMP<N> io_;
+    HybridChannel<N> ch_;
+    bool ready_ = false;
+    Buffers buffers_;
+};
+
+template <typename IO, int N = 2>
+std::unique_ptr<Party> makeNetIOParty(int n, int id, int port) {
+    if (n == N) return std::make_unique<NetIOParty<N, IO>>(id, port);
+    if constexpr (N < kMaxNetIOParties) return makeNetIOParty<IO, N + 1>(n, id, port);
+    return nullptr;
+}
+
+template <int N = 2>
+std::unique_ptr<Party> makeHybridParty(int n, int id, int port) {
+    if (n == N) {
+        auto h = std::make_unique<HybridParty<N>>(id, port);
+        return h->ready() ? std::move(h) : nullptr;
+    }
+    if constexpr (N < kMaxNetIOParties) return makeHybridParty<N + 1>(n, id, port);
+    return nullptr;
+}
+
+// Body of one forked party process; returns its exit code
+int runParty(const Args& args, const std::string& backend, int n, int id, int port, SharedRegion& shared) {
+    alarm(static_cast<unsigned>(args.timeoutSec));
+    std::unique_ptr<Party> party;
+    if (backend == "zmq") {
+        auto z = std::make_unique<ZmqParty>(id, n, port);
+        if (z->ready()) party = std::move(z);
+    } else if (backend == "netio") {
+        party = makeNetIOParty<NetIO>(n, id, port);
+    } else if (backend == "hybrid") {
+        party = makeHybridParty(n, id, port);
+    } else {
+        party = makeNetIOParty<ShmIO>(n, id, port);
+    }
+    if (!party) {
+        shared.fail();
+        return 2;
+    }
+
+    size_t m = 0;
+    for (Pattern p : args.patterns) {
+        for (size_t bytes : args.sizes) {
+            for (int it = 0; it < args.warmup + args.iters; ++it) {
+                if (!shared.barrier()) return 3;
+                if (!party->round(p, bytes)) {
+                    std::cerr << "party " << id << ": " << patternName(p) << " " << bytes << "B failed\n";
+                    shared.fail();
+                    return 3;
+                }
+                const int64_t done = nowNs() - shared.run().releaseNs.load(std::memory_order_relaxed);
+                if (it >= args.warmup) shared.finish(m, it - args.warmup, id) = static_cast<uint64_t>(std::max<int64_t>(0, done));
+            }
+            ++m;
+        }
+    }
+    // Nobody tears down its sockets while a peer may still be reading
+    return shared.barrier() ? 0 : 3;
+}
+
+struct Row {
+    std::string backend;
+    std::string pattern;
+    int parties = 0;
+    size_t size = 0;
+    int iters = 0;
+    LatencyHistogram::Snapshot round;  // slowest party per round
+    double meanPartyUs = 0.0;          // average party finish time
+};
+
+// Fork n parties for one backend, wait for them, and append one row per pattern x size
+bool runConfiguration(const Args& args, const std::string& backend, int n, int port, std::vector<Row>& rows) {
+    const size_t measurements = args.patterns.size() * args.sizes.size();
+    SharedRegion shared(measurements, args.iters, n);
+    std::cout.flush();
+    std::cerr.flush();
+    std::vector<pid_t> pids;
+    for (int id = 1; id <= n; ++id) {
+        const pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            shared.fail();
+            break;
+        }
+        if (pid == 0) _exit(runParty(args, backend, n, id, port, shared));
+        pids.push_back(pid);
+    }
+    bool ok = static_cast<int>(pids.size()) == n;
+    for (pid_t pid : pids) {
+        int status = 0;
+        waitpid(pid, &status, 0);
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) ok = false;
+    }
+    if (!ok) return false;
+
+    size_t m = 0;
+    for (Pattern p : args.patterns) {
+        for (size_t bytes : args.sizes) {
+            LatencyHistogram h;
+            double partySum = 0.0;
+            for (int it = 0; it < args.iters; ++it) {
+                uint64_t slowest = 0;
+                for (int id = 1; id <= n; ++id) {
+                    const uint64_t t = shared.finish(m, it, id);
+                    slowest = std::max(slowest, t);
+                    partySum += static_cast<double>(t);
+                }
+                h.record(slowest);
+            }
+            Row r;
+            r.backend = backend;
+            r.pattern = patternName(p);
+            r.parties = n;
+            r.size = bytes;
+            r.iters = args.iters;
+            r.round = h.snapshot();
+            r.meanPartyUs = partySum / (static_cast<double>(args.iters) * n) / 1000.0;
+            rows.push_back(std::move(r));
+            ++m;
+        }
+    }
+    return true;
+}
+
+double us(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+void writeCsv(std::ostream& out, const std::vector<Row>& rows) {
+    out << "backend,pattern,parties,size,iters,round_mean_us,round_p50_us,round_p99_us,round_max_us,party_mean_us\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& r : rows) {
+        out << r.backend << ',' << r.pattern << ',' << r.parties << ',' << r.size << ',' << r.iters << ','
+            << r.round.meanNs() / 1000.0 << ',' << us(r.round.percentile(0.5)) << ',' << us(r.round.percentile(0.99)) << ','
+            << us(r.round.maxNs) << ',' << r.meanPartyUs << '\n';
+    }
+}
+
+void writeJson(std::ostream& out, const std::vector<Row>& rows) {
+    out << std::fixed << std::setprecision(3) << "[\n";
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const auto& r = rows[i];
+        out << "  {\"backend\":\"" << r.backend << "\",\"pattern\":\"" << r.pattern << "\",\"parties\":" << r.parties
+            << ",\"size\":" << r.size << ",\"iters\":" << r.iters << ",\"round_mean_us\":" << r.round.meanNs() / 1000.0
+            << ",\"round_p50_us\":" << us(r.round.percentile(0.5)) << ",\"round_p99_us\":" << us(r.round.percentile(0.99))
+            << ",\"round_max_us\":" << us(r.round.maxNs) << ",\"party_mean_us\":" << r.meanPartyUs << '}'
+            << (i + 1 < rows.size() ? "," : "") << '\n';
+    }
+    out << "]\n";
+}
+
+void writeText(std::ostream& out, const std::vector<Row>& rows) {
+    out << std::left << std::setw(8) << "backend" << std::setw(11) << "pattern" << std::right << std::setw(4) << "N"
+        << std::setw(10) << "size" << std::setw(12) << "mean_us" << std::setw(12) << "p50_us" << std::setw(12) << "p99_us"
+        << std::setw(12) << "max_us" << std::setw(14) << "party_mean_us" << "\n";
+    out << std::fixed << std::setprecision(1);
+    for (const auto& r : rows) {
+        out << std::left << std::setw(8) << r.backend << std::setw(11) << r.pattern << std::right << std::setw(4) << r.parties
+            << std::setw(10) << r.size << std::setw(12) << r.round.meanNs() / 1000.0 << std::setw(12) << us(r.round.percentile(0.5))
+            << std::setw(12) << us(r.round.percentile(0.99)) << std::setw(12) << us(r.round.maxNs) << std::setw(14) << r.meanPartyUs
+            << "\n";
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const Args args = parseArgs(argc, argv);
+    std::vector<Row> rows;
+    int run = 0;
+    for (const auto& backend : args.backends) {
+        if (backend != "zmq" && backend != "netio" && backend != "shm" && backend != "hybrid") {
+            std::cerr << "unknown backend " << backend << "\n";
+            return 1;
+        }
+        for (int n : args.parties) {
+            if (n < 2 || (backend != "zmq" && n > kMaxNetIOParties)) {
+                std::cerr << "skipping " << backend << " with " << n << " parties (supported: 2.."
+                          << (backend == "zmq" ? std::string("any") : std::to_string(kMaxNetIOParties)) << ")\n";
+                continue;
+            }
+            // Fresh ports per configuration: NetIOMP<N> uses port + 2*(i*N+j) (+1) for each pair
+            const int port = args.base + 2 * (kMaxNetIOParties + 1) * (kMaxNetIOParties + 1) * run++;
+            std::cerr << "running " << backend << " with " << n << " parties\n";
+            if (!runConfiguration(args, backend, n, port, rows)) {
+                std::cerr << backend << " with " << n << " parties failed\n";
+                return 2;
+            }
+        }
+    }
+
+    std::ofstream file;
+    if (!args.out.empty()) {
+        file.open(args.out);
+        if (!file) {
+            std::cerr << "cannot open " << args.out << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = args.out.empty() ? std::cout : file;
+    if (args.format == "csv") writeCsv(out, rows);
+    else if (args.format == "json") writeJson(out, rows);
+    else writeText(out, rows);
+    return 0;
+}
@@ -1,23 +1,62 @@
 #include "Communicator.h"
+#include "CpuAffinity.h"
+#include "PeerMetrics.h"
+#include "netmp.h"
 #include <algorithm>
 #include <chrono>
 #include <cstdint>
+#include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <random>
+#include <sstream>
 #include <string>
+#include <thread>
+#include <type_traits>
 #include <vector>
 
+// Modes:
+//   oneway    DEALER send + ROUTER receive in one thread (zmq only; the original measurement)
+//   pingpong  party 1 sends `size` bytes, party 2 answers with `reply` bytes; RTT per exchange
+//   stream    party 1 keeps `inflight` messages outstanding, party 2 acks each with 1 byte;
+//             reports messages/s and GB/s plus the send-to-ack latency of every message
+// Backends: zmq (Communicator, --transport tcp|ipc|inproc), netio (NetIOMP<2> over TCP),
+// shm (NetIOMP<2, ShmIO>). Latencies go into an HDR-style histogram (PeerMetrics.h).
+// --busy-poll spins receives before blocking (Communicator::setBusyPoll, NetIO::set_busy_poll);
+// --cores pins party 1, party 2 and then the ZMQ I/O threads to the listed cores.
+// --no-pool sends zmq payloads from libzmq allocations instead of the Communicator's buffer pool.
 struct Args {
     std::string address = "127.0.0.1";
     int base = 10000;
-    size_t size = 1 << 20; // 1MB
+    std::string mode = "oneway";
+    std::string backend = "zmq";
+    std::string transport = "tcp";
+    std::vector<size_t> sizes = {1 << 20}; // 1MB
+    long long reply = -1;                  // pingpong reply bytes; -1 = same as size
     int iters = 20;
+    int warmup = 3;
+    int inflight = 16;
+    std::string format = "text";           // text | csv | json
+    std::string out;                       // results file; stdout if empty
+    int busyPollUs = 0;                    // receive spin budget; 0 = block at once
+    std::vector<int> cores;                // party 1, party 2, then ZMQ I/O threads
+    bool pool = true;                      // Communicator::setBufferPoolEnabled
     // Optional: measured network characteristics to compute theoretical latency
     double rtt_ms = -1.0;          // ping RTT in milliseconds
     double bandwidth_gbps = -1.0;  // iperf3 throughput in Gbps
 };
 
+static std::vector<size_t> parseSizes(const std::string& list) {
+    std::vector<size_t> sizes;
+    std::stringstream ss(list);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) sizes.push_back(static_cast<size_t>(std::stoll(item)));
+    }
+    return sizes;
+}
+
 Args parseArgs(int argc, char** argv) {
     Args a;
     for (int i = 1; i < argc; ++i) {
@@ -25,111 +64,394 @@ Args parseArgs(int argc, char** argv) {
         auto next = [&]() -> const char* { return (i + 1 < argc) ? argv[++i] : ""; };
         if (s == "--address") a.address = next();
         else if (s == "--base") a.base = std::stoi(next());
-        else if (s == "--size") a.size = static_cast<size_t>(std::stoll(next()));
+        else if (s == "--mode") a.mode = next();
+        else if (s == "--backend") a.backend = next();
+        else if (s == "--transport") a.transport = next();
+        else if (s == "--size") a.sizes = {static_cast<size_t>(std::stoll(next()))};
+        else if (s == "--sizes") a.sizes = parseSizes(next());
+        else if (s == "--sweep") a.sizes = {8, 64, 512, 4096, 32768, 262144, 1048576};
+        else if (s == "--reply") a.reply = std::stoll(next());
         else if (s == "--iters") a.iters = std::stoi(next());
+        else if (s == "--warmup") a.warmup = std::stoi(next());
+        else if (s == "--inflight") a.inflight = std::max(1, std::stoi(next()));
+        else if (s == "--format") a.format = next();
+        else if (s == "--out") a.out = next();
+        else if (s == "--busy-poll") a.busyPollUs = std::stoi(next());
+        else if (s == "--no-pool") a.pool = false;
+        else if (s == "--cores") {
+            a.cores = cpu::parseCoreList(next());
+            if (a.cores.empty()) {
+                std::cerr << "bad --cores list (e.g. 2,3 or 2-5)\n";
+                std::exit(1);
+            }
+        }
         else if (s == "--rtt_ms") a.rtt_ms = std::stod(next());
         else if (s == "--bandwidth_gbps") a.bandwidth_gbps = std::stod(next());
         else if (s == "-h" || s == "--help") {
-            std::cout << "Usage: LatencyBenchmark [--address 127.0.0.1] [--base 10000] [--size 1048576] [--iters 20]\\n"
-                         "                          [--rtt_ms <ms>] [--bandwidth_gbps <Gbps>]\\n";
+            std::cout << "Usage: LatencyBenchmark [--mode oneway|pingpong|stream] [--backend zmq|netio|shm]\n"
+                         "                        [--transport tcp|ipc|inproc] [--size N | --sizes a,b,c | --sweep]\n"
+                         "                        [--reply N] [--iters 20] [--warmup 3] [--inflight 16]\n"
+                         "                        [--format text|csv|json] [--out file] [--busy-poll <us>] [--cores 2,3,4]\n"
+                         "                        [--no-pool]\n"
+                         "                        [--address 127.0.0.1] [--base 10000] [--rtt_ms <ms>] [--bandwidth_gbps <Gbps>]\n";
             std::exit(0);
         }
     }
     return a;
 }
 
-int main(int argc, char** argv) {
-    auto args = parseArgs(argc, argv);
-    std::cout << "Latency benchmark\n"
-              << " address=" << args.address
-              << " base=" << args.base
-              << " size=" << args.size
-              << " iters=" << args.iters << "\n";
+struct Result {
+    std::string backend;
+    std::string mode;
+    size_t size = 0;
+    size_t reply = 0;
+    int iters = 0;
+    int inflight = 1;
+    LatencyHistogram::Snapshot latency;
+    double seconds = 0.0; // wall time of the timed phase
+};
+
+// One side of a two-party link, created on the thread that uses it
+class Endpoint {
+public:
+    virtual ~Endpoint() = default;
+    virtual bool send(const char* data, size_t n) = 0;
+    // Receive exactly n bytes into data (zmq: one message of n bytes, left in place)
+    virtual bool recv(char* data, size_t n) = 0;
+};
 
+static void applyLatencyMode(Communicator& comm, const Args& args) {
+    comm.setBusyPoll(args.busyPollUs);
+    comm.setBufferPoolEnabled(args.pool);
+    if (args.cores.size() > 2) {
+        const std::vector<int> io(args.cores.begin() + 2, args.cores.end());
+        if (!comm.setIoThreadCores(io)) std::cerr << "could not pin ZMQ I/O threads\n";
+    }
+}
+
+class ZmqEndpoint : public Endpoint {
+public:
+    ZmqEndpoint(int id, const Args& args) : comm_(id, args.base, args.address, 2), peer_(3 - id) {
+        if (args.transport == "ipc") comm_.setTransport(Communicator::Transport::Ipc);
+        else if (args.transport == "inproc") comm_.setTransport(Communicator::Transport::Inproc);
+        applyLatencyMode(comm_, args);
+        comm_.setUpRouterDealer();
+        ready_ = comm_.awaitMeshReady(5000);
+    }
+    bool ready() const { return ready_; }
+    bool send(const char* data, size_t n) override {
+        return comm_.dealerSendTo(peer_, comm_.copyMessage(data, n));
+    }
+    bool recv(char* data, size_t n) override {
+        (void)data; // the payload is read in place from msg_, as zero-copy receivers do
+        return comm_.routerReceiveFrom(peer_, msg_, 5000) && msg_.size() == n;
+    }
+
+private:
+    Communicator comm_;
+    int peer_;
+    bool ready_ = false;
+    zmq::message_t msg_;
+};
+
+template <typename IO>
+class NetIOEndpoint : public Endpoint {
+public:
+    NetIOEndpoint(int party, const Args& args) : io_(party, args.base), peer_(3 - party) {
+        if constexpr (std::is_same<IO, NetIO>::value) {
+            if (args.busyPollUs > 0 && !io_.set_busy_poll(args.busyPollUs))
+                std::cerr << "SO_BUSY_POLL refused (needs CAP_NET_ADMIN above net.core.busy_read); spinning in user space only\n";
+        }
+    }
+    bool send(const char* data, size_t n) override {
+        io_.send_data(peer_, data, n);
+        io_.flush(peer_);
+        return true;
+    }
+    bool recv(char* data, size_t n) override {
+        io_.recv_data(peer_, data, n);
+        return true;
+    }
+
+private:
+    NetIOMP<2, IO> io_;
+    int peer_;
+};
+
+static std::unique_ptr<Endpoint> makeEndpoint(int party, const Args& args) {
+    if (args.backend == "netio") return std::make_unique<NetIOEndpoint<NetIO>>(party, args);
+    if (args.backend == "shm") return std::make_unique<NetIOEndpoint<ShmIO>>(party, args);
+    auto ep = std::make_unique<ZmqEndpoint>(party, args);
+    if (!ep->ready()) return nullptr;
+    return ep;
+}
+
+static uint64_t elapsedNs(std::chrono::steady_clock::time_point t0) {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - t0).count());
+}
+
+static size_t replyBytes(const Args& args, size_t size) {
+    return args.reply < 0 ? size : static_cast<size_t>(args.reply);
+}
+
+// Party 2: answers every message of every size, in the same order party 1 sends them
+static bool runResponder(const Args& args) {
+    if (args.cores.size() > 1) cpu::pinCurrentThread(args.cores[1]);
+    auto ep = makeEndpoint(2, args);
+    if (!ep) return false;
+    const bool stream = args.mode == "stream";
+    std::vector<char> buf;
+    for (size_t size : args.sizes) {
+        const size_t reply = stream ? 1 : replyBytes(args, size);
+        buf.assign(std::max(size, reply), 'r');
+        for (int i = 0; i < args.warmup + args.iters; ++i) {
+            if (!ep->recv(buf.data(), size) || !ep->send(buf.data(), reply)) return false;
+        }
+    }
+    return true;
+}
+
+static bool pingPong(Endpoint& ep, const Args& args, size_t size, Result& r) {
+    const size_t reply = replyBytes(args, size);
+    std::vector<char> payload(size, 'p');
+    std::vector<char> back(std::max<size_t>(reply, 1));
+    for (int i = 0; i < args.warmup; ++i) {
+        if (!ep.send(payload.data(), size) || !ep.recv(back.data(), reply)) return false;
+    }
+    LatencyHistogram h;
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < args.iters; ++i) {
+        const auto t0 = std::chrono::steady_clock::now();
+        if (!ep.send(payload.data(), size) || !ep.recv(back.data(), reply)) return false;
+        h.record(elapsedNs(t0));
+    }
+    r.seconds = static_cast<double>(elapsedNs(start)) / 1e9;
+    r.reply = reply;
+    r.latency = h.snapshot();
+    return true;
+}
+
+// Sends n messages keeping at most `inflight` unacknowledged; acks come back in order
+static bool streamPhase(Endpoint& ep, const Args& args, const std::vector<char>& payload, int n, LatencyHistogram* h) {
+    std::vector<std::chrono::steady_clock::time_point> sentAt(static_cast<size_t>(args.inflight));
+    char ack = 0;
+    int sent = 0;
+    int acked = 0;
+    while (acked < n) {
+        while (sent < n && sent - acked < args.inflight) {
+            sentAt[static_cast<size_t>(sent % args.inflight)] = std::chrono::steady_clock::now();
+            if (!ep.send(payload.data(), payload.size())) return false;
+            ++sent;
+        }
+        if (!ep.recv(&ack, 1)) return false;
+        if (h) h->record(elapsedNs(sentAt[static_cast<size_t>(acked % args.inflight)]));
+        ++acked;
+    }
+    return true;
+}
+
+static bool stream(Endpoint& ep, const Args& args, size_t size, Result& r) {
+    std::vector<char> payload(size, 's');
+    if (!streamPhase(ep, args, payload, args.warmup, nullptr)) return false;
+    LatencyHistogram h;
+    const auto start = std::chrono::steady_clock::now();
+    if (!streamPhase(ep, args, payload, args.iters, &h)) return false;
+    r.seconds = static_cast<double>(elapsedNs(start)) / 1e9;
+    r.reply = 1;
+    r.inflight = args.inflight;
+    r.latency = h.snapshot();
+    return true;
+}
+
+// The original measurement: DEALER send then ROUTER receive on one thread
+static bool oneWay(const Args& args, size_t size, Result& r) {
     // Party A (router id=1), Party B (dealer id=2)
     Communicator router{1, args.base, args.address, 2};
     Communicator dealer{2, args.base, args.address, 2};
+    applyLatencyMode(router, args);
+    dealer.setBusyPoll(args.busyPollUs);
+    dealer.setBufferPoolEnabled(args.pool);
     router.setUpRouter();
     dealer.setUpRouterDealer();
 
     // Prepare random payload (binary-safe)
     std::string payload;
-    payload.resize(args.size);
+    payload.resize(size);
     std::mt19937 rng(12345);
     std::uniform_int_distribution<int> dist(0, 255);
-    for (size_t i = 0; i < args.size; ++i) payload[i] = static_cast<char>(dist(rng));
+    for (size_t i = 0; i < size; ++i) payload[i] = static_cast<char>(dist(rng));
 
     // Warm-up
-    for (int i = 0; i < 3; ++i) {
+    for (int i = 0; i < args.warmup; ++i) {
         dealer.dealerSendTo(1, payload);
         std::string from, recv;
         router.routerReceive(from, recv, 1000);
     }
 
-    std::vector<double> times_ms;
-    times_ms.reserve(args.iters);
-
+    LatencyHistogram h;
+    const auto start = std::chrono::steady_clock::now();
     for (int i = 0; i < args.iters; ++i) {
         auto t0 = std::chrono::steady_clock::now();
         if (!dealer.dealerSendTo(1, payload)) {
             std::cerr << "send failed at iter " << i << "\n";
-            return 2;
+            return false;
         }
         std::string from, recv;
         if (!router.routerReceive(from, recv, 5000)) {
             std::cerr << "receive timeout at iter " << i << "\n";
-            return 3;
+            return false;
+        }
+        h.record(elapsedNs(t0));
+    }
+    r.seconds = static_cast<double>(elapsedNs(start)) / 1e9;
+    r.latency = h.snapshot();
+    return true;
+}
+
+static double us(uint64_t ns) { return static_cast<double>(ns) / 1000.0; }
+
+static double messagesPerSecond(const Result& r) { return r.seconds > 0 ? r.iters / r.seconds : 0.0; }
+static double gbPerSecond(const Result& r) {
+    return r.seconds > 0 ? static_cast<double>(r.size) * r.iters / r.seconds / 1e9 : 0.0;
+}
+
+static void writeCsv(std::ostream& out, const std::vector<Result>& results) {
+    out << "backend,mode,size,reply,iters,inflight,mean_us,p50_us,p99_us,p999_us,max_us,msgs_per_s,gb_per_s\n";
+    out << std::fixed << std::setprecision(3);
+    for (const auto& r : results) {
+        out << r.backend << ',' << r.mode << ',' << r.size << ',' << r.reply << ',' << r.iters << ',' << r.inflight << ','
+            << r.latency.meanNs() / 1000.0 << ',' << us(r.latency.percentile(0.5)) << ','
+            << us(r.latency.percentile(0.99)) << ',' << us(r.latency.percentile(0.999)) << ','
+            << us(r.latency.maxNs) << ',' << messagesPerSecond(r) << ',' << gbPerSecond(r) << '\n';
+    }
+}
+
+static void writeJson(std::ostream& out, const std::vector<Result>& results) {
+    out << std::fixed << std::setprecision(3) << "[\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& r = results[i];
+        out << "  {\"backend\":\"" << r.backend << "\",\"mode\":\"" << r.mode << "\",\"size\":" << r.size
+            << ",\"reply\":" << r.reply << ",\"iters\":" << r.iters << ",\"inflight\":" << r.inflight
+            << ",\"mean_us\":" << r.latency.meanNs() / 1000.0 << ",\"p50_us\":" << us(r.latency.percentile(0.5))
+            << ",\"p99_us\":" << us(r.latency.percentile(0.99)) << ",\"p999_us\":" << us(r.latency.percentile(0.999))
+            << ",\"max_us\":" << us(r.latency.maxNs) << ",\"msgs_per_s\":" << messagesPerSecond(r)
+            << ",\"gb_per_s\":" << gbPerSecond(r) << '}' << (i + 1 < results.size() ? "," : "") << '\n';
+    }
+    out << "]\n";
+}
+
+static void writeText(std::ostream& out, const Args& args, const std::vector<Result>& results) {
+    out << std::fixed << std::setprecision(3);
+    for (const auto& r : results) {
+        out << "Results (" << r.backend << ' ' << r.mode << ", size=" << r.size;
+        if (r.mode == "pingpong") out << ", reply=" << r.reply;
+        if (r.mode == "stream") out << ", inflight=" << r.inflight;
+        out << ")\n"
+            << " mean_us=" << r.latency.meanNs() / 1000.0 << " p50_us=" << us(r.latency.percentile(0.5))
+            << " p99_us=" << us(r.latency.percentile(0.99)) << " p99.9_us=" << us(r.latency.percentile(0.999))
+            << " max_us=" << us(r.latency.maxNs) << "\n";
+        if (r.mode == "stream") {
+            out << " msgs_per_s=" << messagesPerSecond(r) << " GB_per_s=" << gbPerSecond(r) << "\n";
+        }
+        if (r.mode != "oneway") continue;
+
+        const double avg = r.latency.meanNs() / 1e6;
+        const double throughput_MBps = avg > 0 ? (r.size / (1024.0 * 1024.0)) / (avg / 1000.0) : 0.0;
+        out << " throughput_MBps~=" << throughput_MBps << "\n";
+        // If user provided RTT and bandwidth, compute theoretical one-way
+        if (args.rtt_ms > 0.0 && args.bandwidth_gbps > 0.0) {
+            // Transfer time for one message: bits / (Gbps * 1e9) seconds
+            const double bits = static_cast<double>(r.size) * 8.0;
+            const double xfer_ms = (bits / (args.bandwidth_gbps * 1e9)) * 1000.0;
+            const double theory_ms = (args.rtt_ms / 2.0) + xfer_ms;
+            const double delta_ms = avg - theory_ms;
+            const double overhead_pct = theory_ms > 0.0 ? (delta_ms / theory_ms) * 100.0 : 0.0;
+
+            out << "Theoretical (one-way) = RTT/2 + size/bw = "
+                << args.rtt_ms/2.0 << " + " << xfer_ms << " = " << theory_ms << " ms\n"
+                << "Delta (measured - theoretical) = " << delta_ms << " ms"
+                << " (" << overhead_pct << "%)\n";
+        } else {
+            out << "Theoretical one-way ~= RTT/2 + size/bandwidth\n"
+                << " Provide --rtt_ms and --bandwidth_gbps to compute delta.\n"
+                << " Example RTT: ping -c 5 " << args.address << "  (avg rtt)\n"
+                << " Example BW: iperf3 -s (server), iperf3 -c " << args.address
+                << " -n " << (r.size * static_cast<size_t>(args.iters)) << " (throughput)\n";
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    auto args = parseArgs(argc, argv);
+    if (args.mode != "oneway" && args.mode != "pingpong" && args.mode != "stream") {
+        std::cerr << "unknown --mode " << args.mode << "\n";
+        return 1;
+    }
+    if (args.backend != "zmq" && args.backend != "netio" && args.backend != "shm") {
+        std::cerr << "unknown --backend " << args.backend << "\n";
+        return 1;
+    }
+    if (args.mode == "oneway" && args.backend != "zmq") {
+        std::cerr << "--mode oneway needs --backend zmq (use pingpong for NetIOMP)\n";
+        return 1;
+    }
+    if (!args.cores.empty() && !cpu::pinCurrentThread(args.cores[0])) {
+        std::cerr << "could not pin to core " << args.cores[0] << "\n";
+    }
+    if (args.format == "text") {
+        std::cout << "Latency benchmark\n"
+                  << " mode=" << args.mode << " backend=" << args.backend
+                  << " address=" << args.address << " base=" << args.base
+                  << " iters=" << args.iters << "\n";
+    }
+
+    std::vector<Result> results;
+    for (size_t size : args.sizes) {
+        Result r;
+        r.backend = args.backend == "zmq" ? "zmq-" + args.transport : args.backend;
+        r.mode = args.mode;
+        r.size = size;
+        r.iters = args.iters;
+        results.push_back(r);
+    }
+
+    bool ok = true;
+    if (args.mode == "oneway") {
+        for (auto& r : results) {
+            if (!oneWay(args, r.size, r)) return 2;
         }
-        auto t1 = std::chrono::steady_clock::now();
-        double dt = std::chrono::duration<double, std::milli>(t1 - t0).count();
-        times_ms.push_back(dt);
-    }
-
-    auto copy = times_ms;
-    std::sort(copy.begin(), copy.end());
-    auto pct = [&](double p) {
-        if (copy.empty()) return 0.0;
-        size_t idx = static_cast<size_t>(p * (copy.size() - 1));
-        return copy[idx];
-    };
-
-    double sum = 0.0;
-    for (double v : times_ms) sum += v;
-    double avg = sum / times_ms.size();
-    double med = pct(0.5);
-    double p95 = pct(0.95);
-
-    double avg_s = avg / 1000.0;
-    double throughput_MBps = (args.size / (1024.0 * 1024.0)) / avg_s;
-
-    std::cout << std::fixed << std::setprecision(3)
-              << "Results (DEALER->ROUTER, one-way, same process)\n"
-              << " avg_ms=" << avg
-              << " med_ms=" << med
-              << " p95_ms=" << p95
-              << " throughput_MBps~=" << throughput_MBps << "\n";
-
-    // If user provided RTT and bandwidth, compute theoretical one-way
-    if (args.rtt_ms > 0.0 && args.bandwidth_gbps > 0.0) {
-        // Transfer time for one message: bits / (Gbps * 1e9) seconds
-        const double bits = static_cast<double>(args.size) * 8.0;
-        const double xfer_ms = (bits / (args.bandwidth_gbps * 1e9)) * 1000.0;
-        const double theory_ms = (args.rtt_ms / 2.0) + xfer_ms;
-        const double delta_ms = avg - theory_ms;
-        const double overhead_pct = theory_ms > 0.0 ? (delta_ms / theory_ms) * 100.0 : 0.0;
-
-        std::cout << std::fixed << std::setprecision(3)
-                  << "Theoretical (one-way) = RTT/2 + size/bw = "
-                  << args.rtt_ms/2.0 << " + " << xfer_ms << " = " << theory_ms << " ms\n"
-                  << "Delta (measured - theoretical) = " << delta_ms << " ms"
-                  << " (" << overhead_pct << "%)\n";
     } else {
-        std::cout << "Theoretical one-way ~= RTT/2 + size/bandwidth\n"
-                  << " Provide --rtt_ms and --bandwidth_gbps to compute delta.\n"
-                  << " Example RTT: ping -c 5 " << args.address << "  (avg rtt)\n"
-                  << " Example BW: iperf3 -s (server), iperf3 -c " << args.address
-                  << " -n " << (args.size * args.iters) << " (throughput)\n";
+        bool responderOk = true;
+        std::thread responder([&]() { responderOk = runResponder(args); });
+        auto ep = makeEndpoint(1, args);
+        if (!ep) {
+            ok = false;
+        } else {
+            for (auto& r : results) {
+                ok = args.mode == "pingpong" ? pingPong(*ep, args, r.size, r) : stream(*ep, args, r.size, r);
+                if (!ok) break;
+            }
+        }
+        responder.join();
+        ep.reset();
+        ok = ok && responderOk;
+    }
+    if (!ok) {
+        std::cerr << "benchmark failed (peer unreachable, send failure or receive timeout)\n";
+        return 3;
     }
 
+    std::ofstream file;
+    if (!args.out.empty()) {
+        file.open(args.out);
+        if (!file) {
+            std::cerr << "cannot open " << args.out << "\n";
+            return 1;
+        }
+    }
+    std::ostream& out = args.out.empty() ? std::cout : file;
+    if (args.format == "csv") writeCsv(out, results);
+    else if (args.format == "json") writeJson(out, results);
+    else writeText(out, args, results);
     return 0;
 }
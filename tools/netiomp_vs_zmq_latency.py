@@ -4,15 +4,20 @@ Compare avg end-to-end (send+ACK) latencies between:
  - ZeroMQ Router-Dealer Mode
  - EMP-toolkit NetIOMP
 
-Data taken from provided measurements. Produces:
+Both series are measured by tools/LatencyBenchmark.cpp in ping-pong mode with a 1-byte reply
+(`latency_benchmark --mode pingpong --reply 1 --sweep --format csv`), once per backend.
+Pass --csv to plot a CSV saved earlier instead of running the benchmark. Produces:
  - A Markdown-like table printed to stdout
  - A PNG figure with two panels: curves and difference
 """
 
 from dataclasses import dataclass
-from typing import List
-import math
+from typing import Dict, List
+import argparse
+import csv
+import io
 import os
+import subprocess
 import sys
 
 import matplotlib.pyplot as plt
@@ -25,31 +30,53 @@ class Series:
     avg_ms: List[float]
 
 
-def main(out_path: str = None):
-    # Payload sizes in bytes (shared across both series)
-    sizes = [8, 64, 512, 4096, 32768, 262144, 1048576]
-
-    # ZeroMQ avg latencies (ms)
-    zmq_avg = [
-        0.235765,
-        0.241718,
-        0.222789,
-        0.21072,
-        0.255222,
-        0.478296,
-        0.767953,
-    ]
-
-    # NetIOMP avg latencies (ms)
-    netiomp_avg = [
-        0.0903905,
-        0.0908006,
-        0.0908711,
-        0.0927651,
-        0.105374,
-        0.17877,
-        0.399736,
-    ]
+def run_benchmark(bench: str, backend: str, base: int, iters: int) -> str:
+    cmd = [bench, "--mode", "pingpong", "--reply", "1", "--sweep", "--format", "csv",
+           "--backend", backend, "--iters", str(iters), "--warmup", "5", "--base", str(base)]
+    print("Running:", " ".join(cmd), file=sys.stderr)
+    return subprocess.run(cmd, check=True, capture_output=True, text=True).stdout
+
+
+def load_rows(text: str) -> Dict[str, Dict[int, float]]:
+    """backend -> {size: mean latency in ms}"""
+    rows: Dict[str, Dict[int, float]] = {}
+    for row in csv.DictReader(io.StringIO(text)):
+        rows.setdefault(row["backend"], {})[int(row["size"])] = float(row["mean_us"]) / 1000.0
+    return rows
+
+
+def main():
+    here = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("out_path", nargs="?", default=os.path.join(here, "netiomp_vs_zmq_latency.png"))
+    parser.add_argument("--bench", default=os.path.join(here, "..", "build", "tools", "latency_benchmark"),
+                        help="latency_benchmark binary")
+    parser.add_argument("--csv", help="plot this CSV (latency_benchmark --format csv output) instead of running")
+    parser.add_argument("--save-csv", help="also write the measured CSV here")
+    parser.add_argument("--iters", type=int, default=1000)
+    args = parser.parse_args()
+    out_path = args.out_path
+
+    if args.csv:
+        with open(args.csv) as f:
+            text = f.read()
+    else:
+        zmq_csv = run_benchmark(args.bench, "zmq", 44000, args.iters)
+        nio_csv = run_benchmark(args.bench, "netio", 44100, args.iters)
+        # Second header line dropped so the two runs form one CSV
+        text = zmq_csv + "".join(nio_csv.splitlines(keepends=True)[1:])
+        if args.save_csv:
+            with open(args.save_csv, "w") as f:
+                f.write(text)
+
+    rows = load_rows(text)
+    zmq_key = next((k for k in rows if k.startswith("zmq")), None)
+    if zmq_key is None or "netio" not in rows:
+        sys.exit("need both a zmq-* and a netio series in the CSV")
+    # Payload sizes measured for both series
+    sizes = sorted(set(rows[zmq_key]) & set(rows["netio"]))
+    zmq_avg = [rows[zmq_key][s] for s in sizes]
+    netiomp_avg = [rows["netio"][s] for s in sizes]
 
     zmq = Series("ZeroMQ ROUTER/DEALER", sizes, zmq_avg)
     nio = Series("EMP NetIOMP", sizes, netiomp_avg)
@@ -67,9 +94,6 @@ def main(out_path: str = None):
         print(f"| {s:>12} | {a:>16.6f} | {b:>16.6f} | {diff:>17.6f} | {ratio:>14.2f} |")
 
     # Plot
-    if out_path is None:
-        out_path = os.path.join(os.path.dirname(__file__), "netiomp_vs_zmq_latency.png")
-
     fig, (ax1, ax2) = plt.subplots(2, 1, figsize=(8, 7), sharex=True, gridspec_kw={"height_ratios": [3, 2]})
 
     # Upper: both series
@@ -95,5 +119,4 @@ def main(out_path: str = None):
 
 
 if __name__ == "__main__":
-    out = sys.argv[1] if len(sys.argv) > 1 else None
-    main(out)
+    main()